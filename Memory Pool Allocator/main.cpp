@@ -1,7 +1,56 @@
 #include <iostream>
+#include <iomanip>
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
 #include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define MEMORY_POOL_SIMD_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define MEMORY_POOL_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// GCC and Clang compile each x86 kernel for its own instruction set and pick one at run time; MSVC accepts the
+// intrinsics without a target attribute.
+#if defined(MEMORY_POOL_SIMD_X86) && !defined(_MSC_VER)
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SIMD_TARGET(isa)
+#endif
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 struct Block {
     Block* next;
@@ -14,313 +63,5056 @@ struct Node {
     Node(int value) : data(value), next(nullptr) {}
 };
 
+// Node of UnrolledLinkedList: a run of values packed into one block, so the link and count are paid once per
+// Capacity values instead of once per value. 32 values is a whole number of vectors for every SIMD tier, so the
+// scans never take a tail path on a full node.
+struct UnrolledNode {
+    static constexpr int Capacity = 32;
+
+    UnrolledNode* next;
+    int count;
+    int values[Capacity];
+
+    UnrolledNode() : next(nullptr), count(0) {}
+};
+
+// Issues the CPU's spin-wait hint so a waiting core stops hammering the pipeline and yields to its sibling.
+inline void cpuRelax() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Hints that address is about to be read so the line is on its way before the load that needs it. Purely a hint:
+// it never faults, so guessed addresses that turn out wrong or invalid only cost the wasted fetch.
+inline void prefetchRead(const void* address) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#elif defined(__GNUC__)
+    __builtin_prefetch(address, 0, 3);
+#else
+    (void)address;
+#endif
+}
+
+// Test-and-test-and-set lock. Waiters spin on a plain load, which stays in their own cache, and only attempt the
+// exchange once the lock looks free, so a held lock doesn't generate a storm of RMW traffic. Each failed round
+// doubles the pause count up to MaxBackoff; beyond that the waiter yields, since the holder is probably descheduled.
 class Spinlock {
 private:
-    std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    static constexpr unsigned MaxBackoff = 64;
+
+    std::atomic<bool> locked{false};
 
 public:
-    void lockPool() {
-        while (lock.test_and_set(std::memory_order_acquire)) {
-            std::this_thread::yield();
+    // Returns how many failed attempts it took, which pool statistics report as spin counts.
+    size_t lockPool() {
+        size_t spins = 0;
+        unsigned backoff = 1;
+
+        while (locked.exchange(true, std::memory_order_acquire)) {
+            do {
+                spins++;
+
+                if (backoff <= MaxBackoff) {
+                    for (unsigned i = 0; i < backoff; i++) {
+                        cpuRelax();
+                    }
+                    backoff *= 2;
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            } while (locked.load(std::memory_order_relaxed));
         }
+        return spins;
+    }
+
+    bool tryLockPool() {
+        return !locked.load(std::memory_order_relaxed) && !locked.exchange(true, std::memory_order_acquire);
     }
 
     void unlockPool() {
-        lock.clear(std::memory_order_release);
+        locked.store(false, std::memory_order_release);
     }
 };
 
-void* alignPointer(void* ptr, size_t alignment) {
-    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
-        throw std::invalid_argument("Alignment must be a power of two");
+// Lock policy for pools that are only ever used from one thread; every operation compiles away.
+struct NullLock {
+    size_t lockPool() {
+        return 0;
     }
 
-    uintptr_t p = reinterpret_cast<uintptr_t>(ptr);
-    size_t misalignment = p % alignment;
-    size_t adjustment = (alignment - misalignment) % alignment;
+    bool tryLockPool() {
+        return true;
+    }
 
-    uintptr_t aligned = p + adjustment;
+    void unlockPool() {}
+};
 
-    return reinterpret_cast<void*>(aligned);
+// Build with -DMEMORY_POOL_STATS=0 to compile every statistics counter out of the allocation paths.
+#ifndef MEMORY_POOL_STATS
+#define MEMORY_POOL_STATS 1
+#endif
+
+#if MEMORY_POOL_STATS
+#define POOL_STAT(statement) statement
+#else
+#define POOL_STAT(statement)
+#endif
+
+// Build with -DMEMORY_POOL_CHECKS=1 to make DebugChecks the default check policy of every pool.
+#ifndef MEMORY_POOL_CHECKS
+#define MEMORY_POOL_CHECKS 0
+#endif
+
+// Check policy that compiles every check out, leaving the allocation paths exactly as they are unchecked.
+struct NoChecks {
+    static constexpr bool Enabled = false;
+    static constexpr bool Poison = false;
+};
+
+// Check policy for hunting memory bugs. Each block is followed by a guard canary, which also sits in front of
+// the next block, and a per-chunk bitmap records which blocks are handed out, catching double frees, pointers
+// the pool never returned and a corrupted free list handing the same block out twice. With PoisonFreed, freed
+// blocks are filled with a pattern that is verified when they are handed out again, catching writes after free.
+// Violations throw std::logic_error, or std::invalid_argument for pointers that aren't from the pool.
+template<bool PoisonFreed = true>
+struct DebugChecks {
+    static constexpr bool Enabled = true;
+    static constexpr bool Poison = PoisonFreed;
+};
+
+#if MEMORY_POOL_CHECKS
+using DefaultChecks = DebugChecks<>;
+#else
+using DefaultChecks = NoChecks;
+#endif
+
+// Build with -DMEMORY_POOL_PROFILING=1 to have every pool note in poolTrace which path the calling thread's
+// operation took and how long it waited for the pool lock, for the --profile harness to attribute latency.
+#ifndef MEMORY_POOL_PROFILING
+#define MEMORY_POOL_PROFILING 0
+#endif
+
+#if MEMORY_POOL_PROFILING
+#define POOL_PROFILE(statement) statement
+#else
+#define POOL_PROFILE(statement)
+#endif
+
+// Cheapest monotonic timestamp available: the TSC on x86, steady_clock nanoseconds elsewhere. Convert to time
+// with ticksPerNanosecond().
+inline uint64_t profileTicks() {
+#ifdef MEMORY_POOL_SIMD_X86
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
 }
 
-class MemoryPool {
+#if MEMORY_POOL_PROFILING
+// What the pools did on the calling thread since the harness last cleared it.
+struct PoolTrace {
+    uint64_t lockWaitTicks = 0; // Spent in lockPool() after tryLockPool() found the lock held
+    bool sharedPath = false; // Went past the magazine to the shared free list or bump tail
+    bool resized = false; // Grew the pool synchronously
+};
+
+thread_local PoolTrace poolTrace;
+#endif
+
+#ifdef __cpp_lib_hardware_interference_size
+constexpr size_t CacheLineSize = std::hardware_destructive_interference_size;
+#else
+constexpr size_t CacheLineSize = 64;
+#endif
+constexpr size_t MaxThreadSlots = 64; // Threads beyond this count fall back to the shared free list
+constexpr size_t NoThreadSlot = static_cast<size_t>(-1);
+constexpr size_t MagazineCapacity = 32; // Blocks a thread may cache before flushing back to the pool
+constexpr size_t MagazineBatch = 16; // Blocks moved between a magazine and the shared free list per lock
+
+std::atomic<bool> threadSlotsInUse[MaxThreadSlots];
+
+// Gives every live thread a small index so pools can keep per-thread state in plain arrays.
+// The index is released when the thread exits and may be reused by a later thread.
+class ThreadSlot {
 private:
-    Spinlock spinlock;
-    Block* freeList; //pointer to the first available block
-    void* poolStart; // Pointer to the start of the entire memory pool
-    size_t blockSize;
-    size_t totalBlocks;
-    size_t usedBlocks; // Track the number of blocks currently in use
-    size_t alignment;
+    size_t index;
+
+    ThreadSlot() : index(NoThreadSlot) {
+        for (size_t i = 0; i < MaxThreadSlots; i++) {
+            bool expected = false;
+            if (threadSlotsInUse[i].compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                index = i;
+                break;
+            }
+        }
+    }
+
+    ~ThreadSlot() {
+        if (index != NoThreadSlot) {
+            threadSlotsInUse[index].store(false, std::memory_order_release);
+        }
+    }
+
 public:
-    MemoryPool(size_t blocksize, size_t totalBlocks, size_t alignment = alignof(std::max_align_t)) {
-        this->alignment = alignment;
-        initializeMemoryPool(blocksize, totalBlocks);
+    static size_t current() {
+        thread_local ThreadSlot slot;
+        return slot.index;
     }
+};
 
-    ~MemoryPool() {
-        destroyMemoryPool();
+// Counter with one writer at a time: a relaxed load plus store instead of a locked fetch_add on the hot path.
+struct SingleWriterCounter {
+    std::atomic<uint64_t> value{0};
+
+    void add(uint64_t amount) {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
     }
 
-    Block* allocateBlock() {
-        spinlock.lockPool();
+    uint64_t get() const {
+        return value.load(std::memory_order_relaxed);
+    }
+};
 
-        if (!freeList) {
-            resizePool();
-        }
+// A small per-thread stack of free blocks. Only the thread holding the matching slot touches it,
+// so it needs no lock, and the padding keeps neighbouring threads off each other's cache lines.
+struct alignas(CacheLineSize) Magazine {
+    Block* head = nullptr;
+    size_t count = 0;
+#if MEMORY_POOL_STATS
+    SingleWriterCounter allocations; // Blocks handed to the user by the thread owning this slot
+    SingleWriterCounter deallocations;
+    SingleWriterCounter remoteFrees; // Frees this thread routed to another thread's RemoteFreeQueue
+#endif
+};
 
-        if (!freeList) {
-            spinlock.unlockPool();
-            return nullptr;
-        }
+// Blocks other threads freed back to the thread slot that allocated them, in pools built with
+// PoolOptions::remoteFree. Any thread pushes with a CAS; the owner takes the whole stack with one exchange, so
+// the stack is never popped node by node, which rules out ABA, and neither side touches the pool lock. Kept
+// apart from Magazine so remote pushes don't keep stealing the owner's hot cache line.
+struct alignas(CacheLineSize) RemoteFreeQueue {
+    std::atomic<Block*> head{nullptr};
 
-        Block* allocateBlock = freeList;
-        freeList = freeList->next;
-        usedBlocks++;
-        spinlock.unlockPool();
+    void push(Block* block) {
+        Block* top = head.load(std::memory_order_relaxed);
 
-        return allocateBlock;
+        do {
+            block->next = top;
+        } while (!head.compare_exchange_weak(top, block, std::memory_order_release, std::memory_order_relaxed));
     }
 
-    void deallocateBlock(Block* block) {
-        spinlock.lockPool();
-        block->next = freeList;
-        freeList = block;
-        spinlock.unlockPool();
+    Block* takeAll() {
+        return head.load(std::memory_order_relaxed) != nullptr ? head.exchange(nullptr, std::memory_order_acquire) : nullptr;
     }
+};
 
-    void reset() {
-        freeList = static_cast<Block*>(poolStart);
-        usedBlocks = 0;
-    }
-private:
-    void initializeMemoryPool(size_t blockSize, size_t totalBlocks) {
-        this->blockSize = blockSize;
-        this->totalBlocks = totalBlocks;
-        this->alignment = alignment;
+constexpr uint8_t NoOwnerSlot = 0xFF; // Block handed to a thread without a slot, or not handed out since
+static_assert(MaxThreadSlots < NoOwnerSlot, "Owner slots are stored in a byte");
 
-        void* rawPool = operator new(blockSize * totalBlocks + alignment - 1);
+// Snapshot returned by MemoryPool::getStats(). Counters other than the block totals read zero when the pool
+// is built with MEMORY_POOL_STATS=0.
+struct PoolStats {
+    size_t totalBlocks; // Capacity across all chunks
+    size_t checkedOutBlocks; // Blocks taken from the shared free list, including those cached in magazines
+    size_t peakCheckedOutBlocks; // High-water mark of checkedOutBlocks; the capacity the pool actually needed
+    uint64_t liveBlocks; // Blocks currently held by callers
+    uint64_t allocations;
+    uint64_t deallocations;
+    uint64_t resizes;
+    uint64_t resizeBytes;
+    uint64_t lockContentions; // Lock acquisitions that found the lock held
+    uint64_t lockSpins; // Failed attempts spent waiting in those acquisitions
+    uint64_t failedAllocations; // Requests answered with nullptr
+    uint64_t remoteFrees; // Frees routed back to the allocating thread; see PoolOptions::remoteFree
+    uint64_t unboundChunks; // Chunks left on the default placement because PoolOptions::numaNode was refused
+};
 
-        this->poolStart = alignPointer(rawPool, alignment);
+enum class PoolEventType {
+    Resized, // blocks: capacity added
+    ChunksReleased, // blocks: capacity given back by releaseFreeChunks()
+    AllocationFailed // blocks: how many were requested but not provided
+};
 
-        this->freeList = static_cast<Block*>(this->poolStart);
+struct PoolEvent {
+    PoolEventType type;
+    size_t blocks;
+    size_t totalBlocks; // Capacity after the event
+};
 
-        Block* currentBlock = this->freeList;
+// Diagnostics hook. It is always invoked after the pool lock has been released, on the thread that caused the
+// event, so a slow callback only delays that thread and never the other allocators.
+using PoolEventCallback = void (*)(const PoolEvent& event, void* context);
 
-        for (size_t i = 1; i < totalBlocks; i++) {
-            currentBlock->next = reinterpret_cast<Block*>(reinterpret_cast<char*>(currentBlock) + blockSize);
-            currentBlock = currentBlock->next;
-        }
-        currentBlock->next = nullptr;
-    } 
+// Counters shared by all threads. They are only touched on slow paths (lock waits, growth, threads without a
+// slot), so plain relaxed fetch_add is cheap enough; the alignment keeps them off the pool's hot fields.
+struct alignas(CacheLineSize) SharedPoolCounters {
+    std::atomic<uint64_t> allocations{0}; // From threads without a slot and from allocateContiguous()
+    std::atomic<uint64_t> deallocations{0};
+    std::atomic<uint64_t> resizes{0};
+    std::atomic<uint64_t> resizeBytes{0};
+    std::atomic<uint64_t> lockContentions{0};
+    std::atomic<uint64_t> lockSpins{0};
+    std::atomic<uint64_t> failedAllocations{0};
+    std::atomic<uint64_t> unboundChunks{0};
+    std::atomic<size_t> peakCheckedOutBlocks{0};
+};
 
-    void resizePool() {
-        size_t newSize = totalBlocks + (totalBlocks / 2);
+enum class FreeListStrategy {
+    Locked, // Shared free list guarded by the pool Spinlock
+    LockFree // Shared free list is a Treiber stack updated with CAS; the Spinlock only serializes growth
+};
 
-        void* newRawPool = operator new(blockSize * newSize + alignment - 1);
-        if (!newRawPool) {
-            throw std::runtime_error("Memory allocation failed during resize.");
-        }
-        void* newPoolStart = alignPointer(newRawPool, alignment);
+// Treiber stack of free blocks. The head packs a version tag into the unused upper bits of the pointer,
+// so a pop that loses a race against a pop/push of the same block (ABA) fails its CAS instead of
+// corrupting the list. Popped blocks must stay mapped for the lifetime of the stack, because a slow
+// thread may still read the stale next pointer of a block another thread already took.
+class LockFreeFreeList {
+private:
+    static constexpr unsigned TagShift = sizeof(void*) == 8 ? 48 : 32;
+    static constexpr uint64_t PointerMask = (uint64_t(1) << TagShift) - 1;
+
+    std::atomic<uint64_t> head{0};
+
+    static Block* pointerOf(uint64_t value) {
+        return reinterpret_cast<Block*>(static_cast<uintptr_t>(value & PointerMask));
+    }
 
-        Block* newFreeList = static_cast<Block*>(newPoolStart);
-        Block* currentBlock = newFreeList;
+    static uint64_t pack(Block* block, uint64_t previous) {
+        uint64_t tag = (previous >> TagShift) + 1; // Bump the version on every successful update
+        return (tag << TagShift) | static_cast<uint64_t>(reinterpret_cast<uintptr_t>(block));
+    }
+
+public:
+    Block* pop() {
+        uint64_t current = head.load(std::memory_order_acquire);
 
-        for (size_t i = 1; i < newSize; i++) {
-            currentBlock->next = reinterpret_cast<Block*>(reinterpret_cast<char*>(currentBlock) + blockSize);
-            currentBlock = currentBlock->next;
+        while (Block* top = pointerOf(current)) {
+            Block* next = top->next; // May be stale if another thread won the race; the tag makes our CAS fail
+            if (head.compare_exchange_weak(current, pack(next, current), std::memory_order_acquire, std::memory_order_acquire)) {
+                return top;
+            }
         }
+        return nullptr;
+    }
 
-        currentBlock->next = nullptr;
+    void push(Block* block) {
+        pushChain(block, block);
+    }
 
-        currentBlock->next = freeList;
-        freeList = newFreeList;
-        totalBlocks = newSize;
+    // Publishes an already linked chain first..last with a single CAS.
+    void pushChain(Block* first, Block* last) {
+        uint64_t current = head.load(std::memory_order_relaxed);
 
-        std::cout << "Memory pool resized. New size: " << totalBlocks << " blocks." << std::endl;
+        do {
+            last->next = pointerOf(current);
+        } while (!head.compare_exchange_weak(current, pack(first, current), std::memory_order_release, std::memory_order_relaxed));
     }
 
-    void destroyMemoryPool() {
-        operator delete(this->poolStart);
-        this->poolStart = nullptr;
-        this->freeList = nullptr;
-    }  
+    bool empty() const {
+        return pointerOf(head.load(std::memory_order_acquire)) == nullptr;
+    }
+
+    void assign(Block* first) {
+        head.store(pack(first, head.load(std::memory_order_relaxed)), std::memory_order_release);
+    }
 };
 
-class SingleLinkedList {
-private:
-    Spinlock spinlock;
-    Node* head; // Pointer to the head node
-    MemoryPool* pool;
-public:
-    SingleLinkedList(MemoryPool* memoryPool) : head(nullptr), pool(memoryPool) {}
+void* alignPointer(void* ptr, size_t alignment) {
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        throw std::invalid_argument("Alignment must be a power of two");
+    }
 
-    int getLength() {
-        int length = 0;
-        Node* current = head;
+    uintptr_t p = reinterpret_cast<uintptr_t>(ptr);
+    size_t misalignment = p % alignment;
+    size_t adjustment = (alignment - misalignment) % alignment;
 
-        while (current != nullptr) {
-            length++;
-            current = current->next;
-        }
-        return length;
+    uintptr_t aligned = p + adjustment;
+
+    return reinterpret_cast<void*>(aligned);
+}
+
+enum class BackingStore {
+    Heap, // operator new
+    Mapped, // Anonymous mmap / VirtualAlloc, page aligned and returned to the OS directly on release
+    HugePages, // MAP_HUGETLB / MEM_LARGE_PAGES; falls back to Mapped when no huge pages can be reserved
+    TransparentHugePages // 2 MiB aligned mmap plus madvise(MADV_HUGEPAGE); plain Mapped outside Linux
+};
+
+enum class GrowthMode {
+    Geometric, // Each growth adds (factor - 1) times the current capacity
+    Fixed, // Each growth adds `increment` blocks
+    None // Never grows; allocations fail with nullptr once the pool is exhausted
+};
+
+struct GrowthPolicy {
+    GrowthMode mode = GrowthMode::Geometric;
+    double factor = 1.5; // Geometric only; must be above 1.0, the pool constructor rejects anything else
+    size_t increment = 0; // Fixed only; blocks per new chunk, which the constructor requires to be nonzero
+    size_t maxBlocks = 0; // Capacity cap for every kind of growth, reserve() included; 0 means unlimited
+    // When fewer blocks than this are left to hand out, a background thread adds a chunk so request threads
+    // don't have to; 0 means the pool only grows synchronously.
+    size_t lowWatermark = 0;
+};
+
+struct PoolOptions {
+    FreeListStrategy strategy = FreeListStrategy::Locked;
+    BackingStore backing = BackingStore::Heap;
+    bool prefault = false; // Fault every page in when a chunk is created (MAP_POPULATE or a touch pass)
+    int numaNode = -1; // Bind every chunk to this NUMA node, below MaxNumaNodes; -1 leaves placement to the OS
+    GrowthPolicy growth;
+    // Producer/consumer pipelines: a block freed by a thread other than the one that allocated it goes onto the
+    // allocating thread's RemoteFreeQueue instead of the freeing thread's magazine, and comes back to the
+    // allocator the next time its magazine runs dry, so blocks circulate without the shared free list. Costs a
+    // byte per block and a chunk lookup on every allocation and free.
+    bool remoteFree = false;
+};
+
+constexpr size_t HugePageSize = 2 * 1024 * 1024;
+
+// A block of memory obtained from the backing store. `bytes` and `backing` describe what was actually mapped,
+// which can differ from the request after rounding or a huge page fallback.
+constexpr int MaxNumaNodes = 1024; // Nodes a PoolOptions::numaNode can name, the size of the mbind() mask
+
+struct Region {
+    void* base;
+    size_t bytes;
+    BackingStore backing;
+    bool unbound = false; // A NUMA node was asked for but the kernel refused the binding; see allocateRegion()
+};
+
+size_t systemPageSize() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+void touchPages(void* base, size_t bytes) {
+    size_t page = systemPageSize();
+    volatile char* p = static_cast<volatile char*>(base);
+
+    for (size_t offset = 0; offset < bytes; offset += page) {
+        p[offset] = 0;
     }
+}
 
-    void insert(int value) {
-        Block* block = pool->allocateBlock();
+#ifndef _WIN32
+#ifdef MAP_POPULATE
+constexpr int PopulateFlag = MAP_POPULATE;
+#else
+constexpr int PopulateFlag = 0;
+#endif
 
-        if (!block) {
-            std::cout << "Memory pool is full. Cannot allocate new node." << std::endl;
-            return;
-        }
+constexpr int MpolBind = 2; // MPOL_BIND from <numaif.h>, which is only present with libnuma installed
+
+// Restricts the region's future page faults to one NUMA node. Must run before the pages are touched. Returns
+// false if the node is out of range or the kernel refuses it, typically because it is offline; the pages then
+// keep the default placement.
+bool bindToNode(void* base, size_t bytes, int numaNode) {
+#if defined(__linux__) && defined(SYS_mbind)
+    if (numaNode < 0) {
+        return true;
+    }
 
-        Node* newNode = new (block) Node(value); // Placement new to construct Node in the allocated block
+    if (numaNode >= MaxNumaNodes) {
+        return false;
+    }
 
-        if (head == nullptr) { // If the list is empty
-        head = newNode; // Set the head to the new node
-        }
+    unsigned long mask[MaxNumaNodes / (8 * sizeof(unsigned long))] = {};
+    mask[numaNode / (8 * sizeof(unsigned long))] |= 1UL << (numaNode % (8 * sizeof(unsigned long)));
+    return syscall(SYS_mbind, base, bytes, MpolBind, mask, sizeof(mask) * 8, 0) == 0;
+#else
+    static_cast<void>(base);
+    static_cast<void>(bytes);
+    static_cast<void>(numaNode);
+    return true;
+#endif
+}
+#endif
 
-        else {
-            Node* current = head;
+// numaNode >= 0 places the pages on that node; heap memory can't be bound, so Heap is mapped instead. A node
+// the kernel won't bind to doesn't fail the allocation: the region comes back with the default placement and
+// Region::unbound set. Every backing store returns whole pages, so no two regions ever share a page of the
+// PageMap.
+Region allocateRegion(size_t bytes, BackingStore backing, bool prefault, int numaNode = -1) {
+    if (backing == BackingStore::Heap && numaNode < 0) {
+        size_t length = roundUp(bytes, systemPageSize());
+        void* base = operator new(length, std::align_val_t(systemPageSize()));
 
-            while (current->next != nullptr) {
-                current = current->next; //move to the next node
-            }
-            current->next = newNode; // Link the last node to the new node
+        if (prefault) {
+            touchPages(base, length);
         }
+        return Region{base, length, BackingStore::Heap};
     }
 
-    void remove(int value) {
-        if (head == nullptr) return;
+#ifdef _WIN32
+    DWORD node = numaNode >= 0 ? static_cast<DWORD>(numaNode) : NUMA_NO_PREFERRED_NODE;
 
-        Node* current = head;
-        Node* previous = nullptr;
+    if (backing == BackingStore::HugePages && GetLargePageMinimum() != 0) {
+        size_t large = roundUp(bytes, GetLargePageMinimum());
+        void* base = VirtualAllocExNuma(GetCurrentProcess(), nullptr, large, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+            PAGE_READWRITE, node);
 
-        while (current != nullptr && current->data != value) {
-            previous = current;
-            current = current->next;
+        if (base != nullptr) {
+            return Region{base, large, BackingStore::HugePages}; // Large pages are always resident
         }
+    }
 
-        if (current == nullptr) {
-            std::cout << "Value " << value << " not found in the list." << std::endl;
-            return;
-        }
+    size_t length = roundUp(bytes, systemPageSize());
+    void* base = VirtualAllocExNuma(GetCurrentProcess(), nullptr, length, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node);
 
-        if (current == head) { // if the value to be removed is the head node
-            head = head->next; //move head to next node
-        }
-        else {
-            previous->next = current->next; // Bypass the current node
-        }
+    if (base == nullptr) {
+        throw std::bad_alloc();
+    }
 
-        pool->deallocateBlock(reinterpret_cast<Block*>(current));
-        std::cout << "Value " << value << " removed from the list." << std::endl;
+    if (prefault) {
+        touchPages(base, length);
     }
-    
-    Node* merge(Node* left, Node* right) {
-        if (!left) return right;
-        if (!right) return left;
+    return Region{base, length, BackingStore::Mapped};
+#else
+    // Pages faulted by MAP_POPULATE would land before bindToNode() runs, so NUMA pools touch them afterwards.
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    bool populated = prefault && numaNode < 0 && PopulateFlag != 0;
 
-        if (left->data <= right ->data) {
-            left->next = merge(left->next, right);
-            return left;
-        }
-        else {
-            right->next = merge(left, right->next);
-            return right;
-        }
+    if (populated) {
+        flags |= PopulateFlag;
     }
 
-    Node* getMiddle() {
-        return getMiddle(head);
+    Region region{nullptr, 0, BackingStore::Mapped};
+
+#ifdef MAP_HUGETLB
+    if (backing == BackingStore::HugePages) {
+        size_t length = roundUp(bytes, HugePageSize);
+        void* base = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+
+        if (base != MAP_FAILED) {
+            region = Region{base, length, BackingStore::HugePages};
+        }
     }
+#endif
 
-    Node* getMiddle(Node* node) {
-        if (!node || !node->next) {
-            return node;
+#ifdef MADV_HUGEPAGE
+    if (backing == BackingStore::TransparentHugePages) {
+        // Over-map by one huge page and trim both ends so the region starts on a 2 MiB boundary, which is what
+        // lets the kernel back it with huge pages. Populating has to wait until after the madvise.
+        size_t length = roundUp(bytes, HugePageSize);
+        void* mapped = mmap(nullptr, length + HugePageSize, PROT_READ | PROT_WRITE, flags & ~PopulateFlag, -1, 0);
+
+        if (mapped == MAP_FAILED) {
+            throw std::bad_alloc();
         }
-        Node* slow = node;
-        Node* fast = node->next;
 
-        while (fast != nullptr && fast->next != nullptr) {
-            slow = slow->next;
-            fast = fast->next->next;
+        char* base = static_cast<char*>(alignPointer(mapped, HugePageSize));
+        size_t head = base - static_cast<char*>(mapped);
+
+        if (head > 0) {
+            munmap(mapped, head);
         }
+        munmap(base + length, HugePageSize - head);
+        madvise(base, length, MADV_HUGEPAGE);
 
-        return slow;
+        region = Region{base, length, BackingStore::TransparentHugePages};
+        populated = false;
     }
+#endif
 
-    void mergeSort() {
-        head = mergeSort(head); // Start sorting from the head
-    }
+    if (region.base == nullptr) {
+        size_t length = roundUp(bytes, systemPageSize());
+        void* base = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
 
-    Node* mergeSort(Node* node) {
-        if (!node || !node->next) {
-            return node; // Base case: If list is empty or has one node
+        if (base == MAP_FAILED) {
+            throw std::bad_alloc();
         }
+        region = Region{base, length, BackingStore::Mapped};
+    }
 
-        Node* middle = getMiddle(node); // Get the middle node
-        Node* secondHalf = middle->next; // Split the list into two halves
-        middle->next = nullptr; // Break the list into two halves
+    region.unbound = !bindToNode(region.base, region.bytes, numaNode);
 
-        // Recursively sort both halves
-        Node* leftSorted = mergeSort(node);
-        Node* rightSorted = mergeSort(secondHalf);
+    if (prefault && !populated) {
+        touchPages(region.base, region.bytes);
+    }
+    return region;
+#endif
+}
 
-        return merge(leftSorted, rightSorted); // Merge sorted halves
+void releaseRegion(const Region& region) {
+    if (region.backing == BackingStore::Heap) {
+        operator delete(region.base, std::align_val_t(systemPageSize()));
+        return;
     }
 
-    void clear() {
-        spinlock.lockPool();
-        Node* current = head;
+#ifdef _WIN32
+    VirtualFree(region.base, 0, MEM_RELEASE);
+#else
+    munmap(region.base, region.bytes);
+#endif
+}
 
-        while (current != nullptr) {
-            Node* temp = current;
-            current = current->next;
-            pool->deallocateBlock(reinterpret_cast<Block*>(temp));
+// One raw region owned by a pool. Every region a pool allocates is recorded so all of them can be released.
+struct Chunk {
+    Region region; // What the backing store returned; this, not the aligned start, is what gets released
+    char* start; // First aligned block in the region
+    char* end; // One past the last block
+    size_t blockCount;
+    std::atomic<size_t> bumpIndex{0}; // Blocks below this index have been handed out from the untouched tail
+    size_t freeCount; // Scratch count used while trimming
+    std::atomic<uint64_t>* allocatedBits; // Checked pools only: one bit per block currently handed out
+    uint8_t* ownerSlots; // remoteFree pools only: slot of the thread each block was last handed to
+    const void* owner; // Pool the chunk belongs to
+    const void* ownerKind; // Identifies the owner's BasicMemoryPool instantiation, so owner can be cast back safely
+    Chunk* next;
+};
+
+// Maps each page of the address space to the Chunk whose blocks cover it, so any pointer resolves to its chunk
+// and owning pool in three dependent loads without taking a lock. It is a three-level radix tree over the page
+// number of a 48-bit address (the same limit LockFreeFreeList's tags rely on). Lower levels are allocated on
+// first use and never freed, which is what makes lookups safe while other threads register chunks; one leaf
+// covers 16 MiB of address space. A chunk spanning a leaf's whole range is recorded once in the middle level
+// instead, tagged with SpanTag, so registering a chunk costs one store per 16 MiB plus its two partial ends.
+class PageMap {
+public:
+    static constexpr size_t PageShift = 12;
+
+private:
+    static constexpr size_t LevelBits = 12;
+    static constexpr size_t LevelSize = size_t(1) << LevelBits;
+    static constexpr uintptr_t LevelMask = LevelSize - 1;
+    static constexpr uintptr_t SpanTag = 1; // Marks a middle entry holding a Chunk* rather than a Leaf*
+
+    struct Leaf {
+        std::atomic<Chunk*> chunks[LevelSize];
+    };
+
+    struct Middle {
+        std::atomic<uintptr_t> entries[LevelSize]; // Leaf*, Chunk* | SpanTag, or 0
+    };
+
+    std::atomic<Middle*> root[LevelSize];
+
+public:
+    // May return a chunk for a pointer just past its blocks on the same page; callers check the range.
+    Chunk* lookup(const void* ptr) const {
+        uintptr_t page = reinterpret_cast<uintptr_t>(ptr) >> PageShift;
+        Middle* middle = root[(page >> (2 * LevelBits)) & LevelMask].load(std::memory_order_acquire);
+
+        if (middle == nullptr) {
+            return nullptr;
         }
-        head = nullptr;
-        spinlock.unlockPool();
-    }
 
-    void display() const {
-        Node* current = head;
+        uintptr_t entry = middle->entries[(page >> LevelBits) & LevelMask].load(std::memory_order_acquire);
 
-        while (current != nullptr) {
-            std::cout << current->data << " ";
-            current = current->next; 
+        if (entry & SpanTag) {
+            return reinterpret_cast<Chunk*>(entry & ~SpanTag);
         }
-        std::cout << std::endl;
+
+        if (entry == 0) {
+            return nullptr;
+        }
+        return reinterpret_cast<Leaf*>(entry)->chunks[page & LevelMask].load(std::memory_order_acquire);
     }
 
-    ~SingleLinkedList() {
-        spinlock.lockPool();
-        Node* current = head;
+    // Points every page overlapping [base, base + bytes) at chunk; nullptr unregisters them.
+    void assign(const void* base, size_t bytes, Chunk* chunk) {
+        if (bytes == 0) {
+            return;
+        }
 
-        while (current != nullptr) {
-            Node* temp = current;
-            current = current->next; // move to the next node leaving behind the last current that's why we store it in temp
-            temp->~Node();
-            pool->deallocateBlock(reinterpret_cast<Block*>(temp));
+        uintptr_t first = reinterpret_cast<uintptr_t>(base) >> PageShift;
+        uintptr_t last = (reinterpret_cast<uintptr_t>(base) + bytes - 1) >> PageShift;
+
+        for (uintptr_t page = first; page <= last;) {
+            Middle* middle = installed(root[(page >> (2 * LevelBits)) & LevelMask]);
+            std::atomic<uintptr_t>& entry = middle->entries[(page >> LevelBits) & LevelMask];
+            uintptr_t rangeEnd = page | LevelMask; // Last page this middle entry covers
+            uintptr_t current = entry.load(std::memory_order_acquire);
+
+            // Only one live chunk can cover a whole range, so a span entry is only ever replaced by its own
+            // unregistration. A leaf left behind by earlier chunks can't be retired, lookups may be inside it,
+            // so such a range is filled page by page.
+            if ((page & LevelMask) == 0 && rangeEnd <= last && (current == 0 || (current & SpanTag))) {
+                entry.store(chunk != nullptr ? reinterpret_cast<uintptr_t>(chunk) | SpanTag : 0, std::memory_order_release);
+                page = rangeEnd + 1;
+                continue;
+            }
+
+            Leaf* leaf = leafIn(entry);
+
+            for (uintptr_t end = rangeEnd < last ? rangeEnd : last; page <= end; page++) {
+                leaf->chunks[page & LevelMask].store(chunk, std::memory_order_release);
+            }
         }
-        spinlock.unlockPool();
     }
-};
 
-int main() {
-    MemoryPool pool(sizeof(Node), 10); //32 bytes and 10 blocks
+private:
+    static Leaf* leafIn(std::atomic<uintptr_t>& entry) {
+        uintptr_t current = entry.load(std::memory_order_acquire);
 
-    SingleLinkedList list(&pool);
+        if (current == 0) {
+            Leaf* fresh = new Leaf();
 
-    for (int i = 1; i <= 20; ++i) {
-        list.insert(i);
+            if (entry.compare_exchange_strong(current, reinterpret_cast<uintptr_t>(fresh), std::memory_order_acq_rel,
+                    std::memory_order_acquire)) {
+                return fresh;
+            }
+            delete fresh;
+        }
+        return reinterpret_cast<Leaf*>(current);
     }
 
-    std::cout << "Linked list: ";
+    // Returns the middle node in slot, allocating it if it is empty; a thread that loses the race frees its copy.
+    static Middle* installed(std::atomic<Middle*>& slot) {
+        Middle* level = slot.load(std::memory_order_acquire);
+
+        if (level == nullptr) {
+            Middle* fresh = new Middle();
+
+            if (slot.compare_exchange_strong(level, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                level = fresh;
+            }
+            else {
+                delete fresh;
+            }
+        }
+        return level;
+    }
+};
+
+PageMap pageMap; // Shared by every pool in the process
+
+
+template<typename LockPolicy = Spinlock, typename CheckPolicy = DefaultChecks>
+class BasicMemoryPool {
+private:
+    static constexpr uint64_t GuardCanary = 0x5AFEB10C5AFEB10CULL;
+    static constexpr size_t CanarySize = sizeof(uint64_t);
+    static constexpr unsigned char PoisonByte = 0xDD;
+    static constexpr char Kind = 0; // Its address tells this instantiation's chunks apart from other ones'
+
+    alignas(CacheLineSize) LockPolicy poolLock; // Own cache line, so waiters spinning on it don't slow the fields below
+    alignas(CacheLineSize) Block* freeList; //pointer to the first available block
+    LockFreeFreeList lockFreeList; // Used instead of freeList in FreeListStrategy::LockFree
+    FreeListStrategy strategy;
+    BackingStore backing; // Where new chunks come from
+    bool prefault;
+    int numaNode;
+    void* poolStart; // Pointer to the start of the entire memory pool
+    Chunk* chunks; // Registry of every region owned by the pool, newest first
+    std::atomic<Chunk*> bumpChunk; // Chunk whose unallocated tail is carved before growing again
+    size_t blockSize; // Stride between blocks; includes the guard canary in checked pools
+    size_t userSize; // Usable bytes per block, as requested
+    std::atomic<size_t> totalBlocks; // Only changed under the lock; atomic so stats and events can read it anywhere
+    std::atomic<size_t> usedBlocks; // Blocks taken from the shared free list and not yet returned to it
+    size_t alignment;
+    Magazine magazines[MaxThreadSlots]; // Per-thread caches indexed by ThreadSlot
+    RemoteFreeQueue remoteQueues[MaxThreadSlots]; // Indexed like magazines; only used when remoteFree is set
+    bool remoteFree;
+    PoolEventCallback eventCallback;
+    void* eventContext;
+    GrowthPolicy growthPolicy;
+    std::thread grower; // Runs growInBackground() when growthPolicy.lowWatermark is set
+    std::mutex growMutex;
+    std::condition_variable growSignal;
+    std::atomic<bool> growRequested; // Set and cleared under growMutex; read without it as a cheap pre-check
+    bool stopGrower; // Guarded by growMutex
+#if MEMORY_POOL_STATS
+    SharedPoolCounters counters;
+#endif
+public:
+    BasicMemoryPool(size_t blocksize, size_t totalBlocks, size_t alignment = alignof(std::max_align_t),
+                    FreeListStrategy strategy = FreeListStrategy::Locked)
+        : BasicMemoryPool(blocksize, totalBlocks, alignment, PoolOptions{strategy, BackingStore::Heap, false, -1, {}, false}) {}
+
+    BasicMemoryPool(size_t blocksize, size_t totalBlocks, size_t alignment, const PoolOptions& options) {
+        // Either would make every growth step a single block, each paying for its own page-rounded region
+        if (options.growth.mode == GrowthMode::Geometric && !(options.growth.factor > 1.0)) { // Also rejects NaN
+            throw std::invalid_argument("Geometric growth factor must be greater than 1.0");
+        }
+
+        if (options.growth.mode == GrowthMode::Fixed && options.growth.increment == 0) {
+            throw std::invalid_argument("Fixed growth increment must be nonzero");
+        }
+
+        if (options.numaNode >= MaxNumaNodes) {
+            throw std::invalid_argument("NUMA node is out of range");
+        }
+
+        this->alignment = alignment;
+        this->strategy = options.strategy;
+        this->backing = options.backing;
+        this->prefault = options.prefault;
+        this->numaNode = options.numaNode;
+        this->remoteFree = options.remoteFree;
+        this->eventCallback = nullptr;
+        this->eventContext = nullptr;
+        this->growthPolicy = options.growth;
+        this->growRequested.store(false, std::memory_order_relaxed);
+        this->stopGrower = false;
+        initializeMemoryPool(blocksize, totalBlocks);
+
+        if (growthPolicy.lowWatermark > 0) {
+            grower = std::thread(&BasicMemoryPool::growInBackground, this);
+        }
+    }
+
+    ~BasicMemoryPool() {
+        if (grower.joinable()) {
+            {
+                std::lock_guard<std::mutex> guard(growMutex);
+                stopGrower = true;
+            }
+            growSignal.notify_one();
+            grower.join();
+        }
+        destroyMemoryPool();
+    }
+
+    BasicMemoryPool(const BasicMemoryPool&) = delete;
+    BasicMemoryPool& operator=(const BasicMemoryPool&) = delete;
+
+    Block* allocateBlock() {
+        size_t slot = ThreadSlot::current();
+
+        if (slot == NoThreadSlot) {
+            Block* block = allocateShared();
+            POOL_STAT(if (block) counters.allocations.fetch_add(1, std::memory_order_relaxed));
+            return block ? checkAllocate(recordOwner(block, slot)) : nullptr;
+        }
+
+        Magazine& magazine = magazines[slot];
+
+        if (magazine.count == 0 && !(remoteFree && drainRemoteFrees(slot, magazine)) && !refillMagazine(magazine)) {
+            POOL_STAT(counters.failedAllocations.fetch_add(1, std::memory_order_relaxed));
+            emitEvent(PoolEventType::AllocationFailed, 1);
+            return nullptr;
+        }
+
+        Block* allocateBlock = magazine.head;
+        magazine.head = allocateBlock->next;
+        magazine.count--;
+        POOL_STAT(magazine.allocations.add(1));
+
+        return checkAllocate(recordOwner(allocateBlock, slot));
+    }
+
+    void deallocateBlock(Block* block) {
+        checkDeallocate(block);
+        size_t slot = ThreadSlot::current();
+
+        if (slot == NoThreadSlot) {
+            POOL_STAT(counters.deallocations.fetch_add(1, std::memory_order_relaxed));
+            returnChain(block, block, 1);
+            return;
+        }
+
+        if (remoteFree) {
+            uint8_t owner = ownerSlotOf(block);
+
+            if (owner != NoOwnerSlot && owner != slot) {
+                remoteQueues[owner].push(block);
+                POOL_STAT(magazines[slot].deallocations.add(1));
+                POOL_STAT(magazines[slot].remoteFrees.add(1));
+                return;
+            }
+        }
+
+        Magazine& magazine = magazines[slot];
+
+        if (magazine.count >= MagazineCapacity) {
+            flushMagazine(magazine);
+        }
+
+        block->next = magazine.head;
+        magazine.head = block;
+        magazine.count++;
+        POOL_STAT(magazine.deallocations.add(1));
+    }
+
+    // Fills out[0..n) and returns how many blocks were obtained. Blocks cached by the calling thread are used
+    // first; the rest come from the shared free list and the bump tail under a single lock acquisition.
+    size_t allocateBlocks(Block** out, size_t n) {
+        size_t count = 0;
+        size_t slot = ThreadSlot::current();
+
+        if (slot != NoThreadSlot) {
+            Magazine& magazine = magazines[slot];
+
+            while (count < n && magazine.head != nullptr) {
+                out[count++] = magazine.head;
+                magazine.head = magazine.head->next;
+                magazine.count--;
+            }
+        }
+
+        if (count < n) {
+            count += allocateSharedBatch(out + count, n - count);
+        }
+
+        if (remoteFree) {
+            for (size_t i = 0; i < count; i++) {
+                recordOwner(out[i], slot);
+            }
+        }
+
+        if constexpr (CheckPolicy::Enabled) {
+            for (size_t i = 0; i < count; i++) {
+                checkAllocate(out[i]);
+            }
+        }
+
+        POOL_STAT(countUserBlocks(slot, count, &Magazine::allocations, counters.allocations));
+        if (count < n) {
+            POOL_STAT(counters.failedAllocations.fetch_add(1, std::memory_order_relaxed));
+            emitEvent(PoolEventType::AllocationFailed, n - count);
+        }
+        return count;
+    }
+
+    void deallocateBlocks(Block** in, size_t n) {
+        if (n == 0) {
+            return;
+        }
+
+        for (size_t i = 1; i < n; i++) {
+            in[i - 1]->next = in[i];
+        }
+        deallocateChain(in[0], in[n - 1], n);
+    }
+
+    // Returns an already linked chain of count blocks, first..last, to the shared free list in one splice.
+    void deallocateChain(Block* first, Block* last, size_t count) {
+        if constexpr (CheckPolicy::Enabled) {
+            Block* block = first;
+
+            for (size_t i = 0; i < count; i++) {
+                Block* next = block->next;
+                checkDeallocate(block);
+                block = next;
+            }
+        }
+
+        POOL_STAT(countUserBlocks(ThreadSlot::current(), count, &Magazine::deallocations, counters.deallocations));
+        returnChain(first, last, count);
+    }
+
+    // Returns n blocks getBlockStride() apart in memory, lowest address first, or nullptr if n is 0 or the growth
+    // policy won't allow a chunk that large. The run is carved from the bump tail when it fits; otherwise the rest
+    // of that tail moves to the free list and a chunk of at least n blocks is added. Each block of the run may be
+    // freed individually later.
+    Block* allocateContiguous(size_t n) {
+        if (n == 0) {
+            return nullptr;
+        }
+
+        lockShared();
+
+        Chunk* chunk = bumpChunk.load(std::memory_order_acquire);
+        Block* run = nullptr;
+        size_t added = 0;
+        size_t index;
+
+        if (chunk && claimTail(chunk, n, n, index) == n) {
+            run = reinterpret_cast<Block*>(chunk->start + index * blockSize);
+        }
+        else {
+            Block* rest = nullptr;
+
+            if (chunk && takeTail(chunk->blockCount, rest) > 0) {
+                Block* last = rest;
+
+                while (last->next != nullptr) {
+                    last = last->next;
+                }
+                spliceLocked(rest, last);
+            }
+
+            added = growthSize(n);
+
+            if (added == 0) {
+                poolLock.unlockPool();
+                POOL_STAT(counters.failedAllocations.fetch_add(1, std::memory_order_relaxed));
+                emitEvent(PoolEventType::AllocationFailed, n);
+                return nullptr;
+            }
+
+            run = reinterpret_cast<Block*>(addChunk(added, n)->start);
+            countResize(added);
+        }
+        poolLock.unlockPool();
+
+        if (added > 0) {
+            emitEvent(PoolEventType::Resized, added);
+        }
+
+        checkOut(n);
+        POOL_STAT(counters.allocations.fetch_add(n, std::memory_order_relaxed));
+
+        if (remoteFree) {
+            size_t slot = ThreadSlot::current();
+
+            for (size_t i = 0; i < n; i++) {
+                recordOwner(reinterpret_cast<Block*>(reinterpret_cast<char*>(run) + i * blockSize), slot);
+            }
+        }
+
+        if constexpr (CheckPolicy::Enabled) {
+            for (size_t i = 0; i < n; i++) {
+                checkAllocate(reinterpret_cast<Block*>(reinterpret_cast<char*>(run) + i * blockSize));
+            }
+        }
+
+        return run;
+    }
+
+    // Makes sure at least `blocks` more blocks can be handed out without growing on the allocation path, adding
+    // one chunk for the shortfall. Meant for warmup; it ignores the growth mode, so even a GrowthMode::None pool
+    // can be sized this way, but not the maxBlocks cap. The region is allocated before the lock is taken.
+    // Returns the number of blocks added.
+    size_t reserve(size_t blocks) {
+        size_t available = totalBlocks.load(std::memory_order_relaxed) - usedBlocks.load(std::memory_order_relaxed);
+
+        if (available >= blocks) {
+            return 0;
+        }
+
+        size_t added = blocks - available;
+
+        if (growthPolicy.maxBlocks != 0) {
+            size_t total = totalBlocks.load(std::memory_order_relaxed);
+            size_t room = growthPolicy.maxBlocks > total ? growthPolicy.maxBlocks - total : 0;
+            added = added < room ? added : room;
+        }
+
+        return added > 0 ? publishGrowth(createChunk(added)) : 0;
+    }
+
+    // Takes over a region whose first blockCount blocks, `offset` bytes in and getBlockStride() apart, already
+    // hold live data, like a loaded snapshot. They count as handed out to the caller and are freed one by one as
+    // usual; the region goes back through releaseRegion() with its chunk. Returns the first block, or nullptr
+    // without taking the region if the blocks aren't aligned for this pool. Like reserve(), not subject to the
+    // growth policy.
+    Block* adoptRegion(const Region& region, size_t offset, size_t blockCount) {
+        char* start = static_cast<char*>(region.base) + offset;
+
+        if (blockCount == 0 || reinterpret_cast<uintptr_t>(start) % alignment != 0
+            || offset + blockCount * blockSize > region.bytes) {
+            return nullptr;
+        }
+
+        size_t slot = ThreadSlot::current();
+        Chunk* chunk = wrapRegion(region, start, blockCount, blockCount);
+
+        if constexpr (CheckPolicy::Enabled) {
+            for (size_t i = 0; i < blockCount; i++) {
+                chunk->allocatedBits[i / 64].fetch_or(uint64_t(1) << (i % 64), std::memory_order_relaxed);
+            }
+        }
+
+        if (remoteFree) {
+            std::memset(chunk->ownerSlots, slot == NoThreadSlot ? NoOwnerSlot : static_cast<uint8_t>(slot), blockCount);
+        }
+
+        lockShared();
+        Chunk* bump = bumpChunk.load(std::memory_order_relaxed);
+        linkChunk(chunk);
+        bumpChunk.store(bump, std::memory_order_release); // The new chunk has no tail to carve
+        poolLock.unlockPool();
+
+        emitEvent(PoolEventType::Resized, blockCount);
+        checkOut(blockCount);
+        POOL_STAT(countUserBlocks(slot, blockCount, &Magazine::allocations, counters.allocations));
+
+        return reinterpret_cast<Block*>(start);
+    }
+
+    size_t getBlockSize() const {
+        return userSize;
+    }
+
+    // Distance between neighbouring blocks; larger than getBlockSize() only in checked pools.
+    size_t getBlockStride() const {
+        return blockSize;
+    }
+
+    // Alignment every block is guaranteed to have: the requested alignment, reduced to the largest power of two
+    // dividing blockSize when blocks are not a multiple of it.
+    size_t getAlignment() const {
+        size_t strideAlignment = blockSize & (~blockSize + 1);
+        return strideAlignment < alignment ? strideAlignment : alignment;
+    }
+
+    // True if ptr points into one of this pool's chunks. O(1) through the PageMap and takes no lock.
+    bool owns(const void* ptr) const {
+        return findChunk(ptr) != nullptr;
+    }
+
+    // The pool of this type whose chunk ptr points into, or nullptr. Lets a free be routed to the right pool among
+    // several (size classes, NUMA nodes) without asking each one.
+    static BasicMemoryPool* ownerOf(const void* ptr) {
+        Chunk* chunk = chunkFor(ptr);
+
+        if (chunk == nullptr || chunk->ownerKind != &Kind) {
+            return nullptr;
+        }
+        return static_cast<BasicMemoryPool*>(const_cast<void*>(chunk->owner));
+    }
+
+    // Sums the per-thread and shared counters. Each counter is read individually with relaxed loads, so under
+    // concurrent use the snapshot is approximate but never torn.
+    PoolStats getStats() const {
+        PoolStats stats{};
+        stats.totalBlocks = totalBlocks.load(std::memory_order_relaxed);
+        stats.checkedOutBlocks = usedBlocks.load(std::memory_order_relaxed);
+#if MEMORY_POOL_STATS
+        stats.peakCheckedOutBlocks = counters.peakCheckedOutBlocks.load(std::memory_order_relaxed);
+        stats.allocations = counters.allocations.load(std::memory_order_relaxed);
+        stats.deallocations = counters.deallocations.load(std::memory_order_relaxed);
+
+        for (const Magazine& magazine : magazines) {
+            stats.allocations += magazine.allocations.get();
+            stats.deallocations += magazine.deallocations.get();
+        }
+
+        stats.liveBlocks = stats.allocations - stats.deallocations;
+        stats.resizes = counters.resizes.load(std::memory_order_relaxed);
+        stats.resizeBytes = counters.resizeBytes.load(std::memory_order_relaxed);
+        stats.lockContentions = counters.lockContentions.load(std::memory_order_relaxed);
+        stats.lockSpins = counters.lockSpins.load(std::memory_order_relaxed);
+        stats.failedAllocations = counters.failedAllocations.load(std::memory_order_relaxed);
+        stats.unboundChunks = counters.unboundChunks.load(std::memory_order_relaxed);
+
+        for (const Magazine& magazine : magazines) {
+            stats.remoteFrees += magazine.remoteFrees.get();
+        }
+#endif
+        return stats;
+    }
+
+    // Installs the diagnostics hook (nullptr removes it). Set it before the pool is shared between threads.
+    void setEventCallback(PoolEventCallback callback, void* context = nullptr) {
+        eventCallback = callback;
+        eventContext = context;
+    }
+
+    // Arena-style bulk free: every block of every chunk becomes free at once by rewinding each chunk's bump index
+    // and dropping the free lists and magazines, with no per-block walk, so the cost is O(chunks). Chunks added
+    // by resizes are kept and carved again before the pool grows. Anything still pointing into the pool is
+    // invalidated, and no other thread may be using the pool while this runs. The pool's own grower thread can't
+    // be stopped by callers, so the rewind holds the lock: a chunk the grower links while a reset is under way
+    // lands either before it, and is rewound, or after it, and becomes the bump chunk with its whole tail.
+    void reset() {
+        POOL_STAT(counters.deallocations.fetch_add(getStats().liveBlocks, std::memory_order_relaxed));
+
+        lockShared();
+
+        if (grower.joinable()) { // Nothing is checked out any more, so a pending request is stale
+            std::lock_guard<std::mutex> guard(growMutex);
+            growRequested.store(false, std::memory_order_relaxed);
+        }
+
+        freeList = nullptr;
+        lockFreeList.assign(nullptr);
+        usedBlocks.store(0, std::memory_order_relaxed);
+
+        for (Magazine& magazine : magazines) {
+            magazine.head = nullptr;
+            magazine.count = 0;
+        }
+
+        for (RemoteFreeQueue& queue : remoteQueues) {
+            queue.head.store(nullptr, std::memory_order_relaxed);
+        }
+
+        for (Chunk* chunk = chunks; chunk != nullptr; chunk = chunk->next) {
+            chunk->bumpIndex.store(0, std::memory_order_relaxed);
+            resetChecks(chunk);
+        }
+        bumpChunk.store(chunks, std::memory_order_release);
+        poolLock.unlockPool();
+    }
+
+    // Gives chunks added by resizePool() back to the OS once every one of their blocks is on the shared free
+    // list. Blocks cached in other threads' magazines keep their chunk alive. The free list is walked to count
+    // free blocks per chunk, O(free blocks + chunks) under the lock, so call it from maintenance points rather
+    // than the allocation path. Blocks waiting in remote-free queues are moved to the free list first, which also
+    // recovers those queued for threads that have since exited. Lock-free pools never unmap memory (see
+    // LockFreeFreeList) and always return 0. Returns the number of chunks released.
+    size_t releaseFreeChunks() {
+        if (strategy == FreeListStrategy::LockFree) {
+            return 0;
+        }
+
+        size_t slot = ThreadSlot::current();
+
+        lockShared();
+
+        if (slot != NoThreadSlot && magazines[slot].count > 0) { // Our own cached blocks can go back first
+            Magazine& magazine = magazines[slot];
+            Block* last = magazine.head;
+
+            while (last->next != nullptr) {
+                last = last->next;
+            }
+            last->next = freeList;
+            freeList = magazine.head;
+            checkIn(magazine.count);
+            magazine.head = nullptr;
+            magazine.count = 0;
+        }
+
+        if (remoteFree) {
+            for (RemoteFreeQueue& queue : remoteQueues) {
+                Block* first = queue.takeAll();
+
+                if (first == nullptr) {
+                    continue;
+                }
+
+                Block* last = first;
+                size_t count = 1;
+
+                for (; last->next != nullptr; last = last->next) {
+                    count++;
+                }
+                last->next = freeList;
+                freeList = first;
+                checkIn(count);
+            }
+        }
+
+        for (Chunk* chunk = chunks; chunk != nullptr; chunk = chunk->next) {
+            chunk->freeCount = chunk->blockCount - chunk->bumpIndex.load(std::memory_order_relaxed); // Untouched tail
+        }
+
+        for (Block* block = freeList; block != nullptr; block = block->next) {
+            findChunk(block)->freeCount++;
+        }
+
+        // Drop blocks of fully free chunks from the free list, then the chunks themselves.
+        Block** blockLink = &freeList;
+
+        while (*blockLink != nullptr) {
+            Chunk* owner = findChunk(*blockLink);
+
+            if (owner->freeCount == owner->blockCount && owner->start != poolStart) {
+                *blockLink = (*blockLink)->next;
+            }
+            else {
+                blockLink = &(*blockLink)->next;
+            }
+        }
+
+        Chunk** link = &chunks;
+        size_t released = 0;
+        size_t releasedBlocks = 0;
+        bool cursorReleased = false;
+
+        while (*link != nullptr) {
+            Chunk* chunk = *link;
+
+            if (chunk->freeCount == chunk->blockCount && chunk->start != poolStart) {
+                cursorReleased = cursorReleased || bumpChunk.load(std::memory_order_relaxed) == chunk;
+                *link = chunk->next;
+                totalBlocks.fetch_sub(chunk->blockCount, std::memory_order_relaxed);
+                releasedBlocks += chunk->blockCount;
+                releaseChunk(chunk);
+                released++;
+            }
+            else {
+                link = &chunk->next;
+            }
+        }
+
+        // The cursor only moves towards older chunks, so it restarts at the newest survivor with a tail left;
+        // the tails of every chunk after it, the initial one included, stay reachable.
+        if (cursorReleased) {
+            Chunk* cursor = chunks;
+
+            while (cursor != nullptr && cursor->bumpIndex.load(std::memory_order_relaxed) >= cursor->blockCount) {
+                cursor = cursor->next;
+            }
+            bumpChunk.store(cursor, std::memory_order_relaxed);
+        }
+        poolLock.unlockPool();
+
+        if (released > 0) {
+            emitEvent(PoolEventType::ChunksReleased, releasedBlocks);
+        }
+
+        return released;
+    }
+private:
+    Block* allocateShared() {
+        POOL_PROFILE(poolTrace.sharedPath = true);
+
+        if (strategy == FreeListStrategy::LockFree) {
+            Block* block = lockFreeList.pop();
+
+            while (!block && takeTail(1, block) == 0) {
+                if (!growLockFree()) {
+                    POOL_STAT(counters.failedAllocations.fetch_add(1, std::memory_order_relaxed));
+                    emitEvent(PoolEventType::AllocationFailed, 1);
+                    return nullptr;
+                }
+                block = lockFreeList.pop();
+            }
+            checkOut(1);
+            return block;
+        }
+
+        lockShared();
+
+        Block* allocateBlock = freeList;
+        size_t added = 0;
+
+        if (allocateBlock) {
+            freeList = allocateBlock->next;
+        }
+        else if (takeTail(1, allocateBlock) == 0) {
+            added = resizePool();
+            takeTail(1, allocateBlock);
+        }
+        poolLock.unlockPool();
+
+        if (added > 0) {
+            emitEvent(PoolEventType::Resized, added);
+        }
+
+        if (!allocateBlock) {
+            POOL_STAT(counters.failedAllocations.fetch_add(1, std::memory_order_relaxed));
+            emitEvent(PoolEventType::AllocationFailed, 1);
+            return nullptr;
+        }
+
+        checkOut(1);
+
+        return allocateBlock;
+    }
+
+    // Splices a chain back onto the shared free list. Unlike deallocateChain() this is not a user free: the
+    // blocks may come from a magazine, where they were already counted.
+    void returnChain(Block* first, Block* last, size_t count) {
+        if (strategy == FreeListStrategy::LockFree) {
+            lockFreeList.pushChain(first, last);
+        }
+        else {
+            lockShared();
+            spliceLocked(first, last);
+            poolLock.unlockPool();
+        }
+        checkIn(count);
+    }
+
+    // Every block leaving the shared state passes through here, off the magazine fast path, which makes it the
+    // place to wake the background grower.
+    void checkOut(size_t count) {
+        size_t now = usedBlocks.fetch_add(count, std::memory_order_relaxed) + count;
+#if MEMORY_POOL_STATS
+        size_t peak = counters.peakCheckedOutBlocks.load(std::memory_order_relaxed);
+
+        while (now > peak && !counters.peakCheckedOutBlocks.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+        }
+#endif
+
+        // growthSize() is 0 once the cap is reached; the grower could add nothing, so it isn't woken for nothing
+        if (growthPolicy.lowWatermark > 0 && totalBlocks.load(std::memory_order_relaxed) < now + growthPolicy.lowWatermark
+            && !growRequested.load(std::memory_order_relaxed) && growthSize(1) > 0) {
+            {
+                std::lock_guard<std::mutex> guard(growMutex);
+                growRequested.store(true, std::memory_order_relaxed);
+            }
+            growSignal.notify_one();
+        }
+    }
+
+    void checkIn(size_t count) {
+        usedBlocks.fetch_sub(count, std::memory_order_relaxed);
+    }
+
+#if MEMORY_POOL_STATS
+    // Adds to the calling thread's counter when it has a slot, otherwise to the shared one.
+    void countUserBlocks(size_t slot, size_t count, SingleWriterCounter Magazine::*perThread, std::atomic<uint64_t>& shared) {
+        if (slot != NoThreadSlot) {
+            (magazines[slot].*perThread).add(count);
+        }
+        else {
+            shared.fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+#endif
+
+    void emitEvent(PoolEventType type, size_t blocks) {
+        if (eventCallback != nullptr) {
+            eventCallback(PoolEvent{type, blocks, totalBlocks.load(std::memory_order_relaxed)}, eventContext);
+        }
+    }
+
+    void lockShared() {
+        if (poolLock.tryLockPool()) {
+            return;
+        }
+
+        POOL_PROFILE(uint64_t waitStart = profileTicks());
+#if MEMORY_POOL_STATS
+        counters.lockContentions.fetch_add(1, std::memory_order_relaxed);
+        counters.lockSpins.fetch_add(poolLock.lockPool() + 1, std::memory_order_relaxed);
+#else
+        poolLock.lockPool();
+#endif
+        POOL_PROFILE(poolTrace.lockWaitTicks += profileTicks() - waitStart);
+    }
+
+    size_t allocateSharedBatch(Block** out, size_t n) {
+        size_t count = 0;
+        Block* chain = nullptr;
+
+        if (strategy == FreeListStrategy::LockFree) {
+            while (count < n) {
+                Block* block = lockFreeList.pop();
+
+                if (block) {
+                    out[count++] = block;
+                    continue;
+                }
+
+                if (takeTail(n - count, chain) == 0 && !growLockFree()) {
+                    break;
+                }
+
+                for (; chain != nullptr; chain = chain->next) {
+                    out[count++] = chain;
+                }
+            }
+            checkOut(count);
+            return count;
+        }
+
+        size_t added = 0;
+
+        lockShared();
+
+        while (count < n) {
+            if (freeList) {
+                out[count++] = freeList;
+                freeList = freeList->next;
+                continue;
+            }
+
+            if (takeTail(n - count, chain) == 0) {
+                added += resizePool();
+
+                if (takeTail(n - count, chain) == 0) {
+                    break;
+                }
+            }
+
+            for (; chain != nullptr; chain = chain->next) {
+                out[count++] = chain;
+            }
+        }
+        poolLock.unlockPool();
+
+        if (added > 0) {
+            emitEvent(PoolEventType::Resized, added);
+        }
+
+        checkOut(count);
+        return count;
+    }
+
+    // Moves up to MagazineBatch blocks from the shared free list into the magazine under one lock.
+    bool refillMagazine(Magazine& magazine) {
+        POOL_PROFILE(poolTrace.sharedPath = true);
+
+        if (strategy == FreeListStrategy::LockFree) {
+            while (magazine.count < MagazineBatch) {
+                Block* block = lockFreeList.pop();
+
+                if (!block) {
+                    magazine.count += takeTail(MagazineBatch - magazine.count, magazine.head);
+
+                    if (magazine.count > 0 || !growLockFree()) {
+                        break;
+                    }
+                    continue;
+                }
+
+                block->next = magazine.head;
+                magazine.head = block;
+                magazine.count++;
+            }
+            checkOut(magazine.count);
+            return magazine.count > 0;
+        }
+
+        lockShared();
+        size_t before = magazine.count;
+        size_t added = 0;
+
+        while (magazine.count < MagazineBatch) {
+            if (!freeList) {
+                size_t wanted = MagazineBatch - magazine.count;
+                size_t taken = takeTail(wanted, magazine.head);
+
+                if (taken == 0) {
+                    added = resizePool();
+                    taken = takeTail(wanted, magazine.head);
+                }
+                magazine.count += taken;
+                break;
+            }
+
+            Block* block = freeList;
+            freeList = freeList->next;
+            block->next = magazine.head;
+            magazine.head = block;
+            magazine.count++;
+        }
+        poolLock.unlockPool();
+
+        if (added > 0) {
+            emitEvent(PoolEventType::Resized, added);
+        }
+
+        checkOut(magazine.count - before);
+        return magazine.count > 0;
+    }
+
+    // Moves the blocks other threads freed back to this slot into its empty magazine, keeping at most
+    // MagazineCapacity and returning the rest to the shared free list. Returns false if the queue was empty.
+    bool drainRemoteFrees(size_t slot, Magazine& magazine) {
+        Block* first = remoteQueues[slot].takeAll();
+
+        if (first == nullptr) {
+            return false;
+        }
+
+        Block* last = first;
+        size_t count = 1;
+
+        for (; count < MagazineCapacity && last->next != nullptr; last = last->next) {
+            count++;
+        }
+
+        Block* rest = last->next;
+        last->next = nullptr;
+        magazine.head = first;
+        magazine.count = count;
+
+        if (rest != nullptr) {
+            Block* restLast = rest;
+            size_t restCount = 1;
+
+            for (; restLast->next != nullptr; restLast = restLast->next) {
+                restCount++;
+            }
+            returnChain(rest, restLast, restCount);
+        }
+        return true;
+    }
+
+    // remoteFree pools: remembers which slot the block is being handed to, so a free from another thread can be
+    // routed back there.
+    Block* recordOwner(Block* block, size_t slot) {
+        if (remoteFree) {
+            Chunk* chunk = findChunk(block);
+            chunk->ownerSlots[(reinterpret_cast<char*>(block) - chunk->start) / blockSize] =
+                slot == NoThreadSlot ? NoOwnerSlot : static_cast<uint8_t>(slot);
+        }
+        return block;
+    }
+
+    uint8_t ownerSlotOf(const Block* block) const {
+        Chunk* chunk = findChunk(block);
+        return chunk->ownerSlots[(reinterpret_cast<const char*>(block) - chunk->start) / blockSize];
+    }
+
+    // Detaches MagazineBatch blocks from the magazine and splices them onto the shared free list.
+    void flushMagazine(Magazine& magazine) {
+        Block* first = magazine.head;
+        Block* last = first;
+
+        for (size_t i = 1; i < MagazineBatch; i++) {
+            last = last->next;
+        }
+        magazine.head = last->next;
+        magazine.count -= MagazineBatch;
+
+        returnChain(first, last, MagazineBatch);
+    }
+
+    // Only growth takes the lock in lock-free mode; whoever gets it first grows, the rest just retry the pop.
+    // Returns false when the pool is exhausted and the growth policy won't add to it.
+    bool growLockFree() {
+        lockShared();
+
+        Chunk* chunk = bumpChunk.load(std::memory_order_acquire);
+        bool tailExhausted = !chunk || chunk->bumpIndex.load(std::memory_order_relaxed) >= chunk->blockCount;
+
+        size_t added = 0;
+        bool retry = true;
+
+        if (lockFreeList.empty() && tailExhausted) {
+            added = resizePool();
+            retry = added > 0;
+        }
+        poolLock.unlockPool();
+
+        if (added > 0) {
+            emitEvent(PoolEventType::Resized, added);
+        }
+        return retry;
+    }
+
+    // Body of the grower thread. The region is allocated without the lock; only linking the finished chunk in
+    // takes it, so request threads never wait on the allocation. Resized events from here arrive on this thread.
+    void growInBackground() {
+        std::unique_lock<std::mutex> guard(growMutex);
+
+        while (true) {
+            growSignal.wait(guard, [this] { return stopGrower || growRequested.load(std::memory_order_relaxed); });
+
+            if (stopGrower) {
+                return;
+            }
+            guard.unlock();
+
+            size_t used = usedBlocks.load(std::memory_order_relaxed);
+            size_t blocks = totalBlocks.load(std::memory_order_relaxed) < used + growthPolicy.lowWatermark ? growthSize(1) : 0;
+
+            if (blocks > 0) {
+                publishGrowth(createChunk(blocks));
+            }
+
+            guard.lock();
+            growRequested.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    // Links a chunk built outside the lock into the pool, unless growth elsewhere has since used up the room
+    // under the cap. Returns the number of blocks added.
+    size_t publishGrowth(Chunk* chunk) {
+        size_t added = chunk->blockCount;
+
+        lockShared();
+
+        if (growthPolicy.maxBlocks != 0 && totalBlocks.load(std::memory_order_relaxed) + added > growthPolicy.maxBlocks) {
+            poolLock.unlockPool();
+            releaseChunk(chunk);
+            return 0;
+        }
+
+        linkChunk(chunk);
+        countResize(added);
+        poolLock.unlockPool();
+
+        emitEvent(PoolEventType::Resized, added);
+        return added;
+    }
+
+    void initializeMemoryPool(size_t blockSize, size_t totalBlocks) {
+        this->userSize = blockSize;
+
+        if constexpr (CheckPolicy::Enabled) { // Room for the canary without losing the blocks' alignment
+            size_t strideAlignment = blockSize & (~blockSize + 1);
+            blockSize += roundUp(CanarySize, strideAlignment < alignment ? strideAlignment : alignment);
+        }
+
+        this->blockSize = blockSize;
+        this->totalBlocks.store(0, std::memory_order_relaxed);
+        this->usedBlocks.store(0, std::memory_order_relaxed);
+        this->chunks = nullptr;
+        this->bumpChunk.store(nullptr, std::memory_order_relaxed);
+        this->freeList = nullptr;
+
+        this->poolStart = addChunk(totalBlocks)->start;
+    } 
+
+    // Called with the lock held; returns the number of blocks added, 0 if the growth policy refuses, so the
+    // caller can emit the Resized event once it has unlocked.
+    size_t resizePool() {
+        size_t growth = growthSize(1);
+
+        if (growth == 0) {
+            return 0;
+        }
+
+        addChunk(growth);
+        countResize(growth);
+        POOL_PROFILE(poolTrace.resized = true);
+
+        return growth;
+    }
+
+    // Blocks the next growth adds under the policy, at least `minimum`, or 0 if the mode or the cap forbids it.
+    size_t growthSize(size_t minimum) const {
+        size_t total = totalBlocks.load(std::memory_order_relaxed);
+        size_t growth = 0;
+
+        switch (growthPolicy.mode) {
+        case GrowthMode::None:
+            return 0;
+        case GrowthMode::Fixed:
+            growth = growthPolicy.increment;
+            break;
+        case GrowthMode::Geometric: {
+            double scaled = total * (growthPolicy.factor - 1.0); // Clamped before the cast, which overflow makes UB
+            growth = scaled < static_cast<double>(maxChunkBlocks()) ? static_cast<size_t>(scaled) : maxChunkBlocks();
+            break;
+        }
+        }
+
+        if (minimum > maxChunkBlocks()) {
+            return 0;
+        }
+
+        growth = growth > minimum ? growth : minimum;
+        growth = growth < maxChunkBlocks() ? growth : maxChunkBlocks();
+
+        if (growthPolicy.maxBlocks != 0) {
+            size_t room = growthPolicy.maxBlocks > total ? growthPolicy.maxBlocks - total : 0;
+
+            if (room < minimum) {
+                return 0;
+            }
+            growth = growth < room ? growth : room;
+        }
+        return growth;
+    }
+
+    // Largest chunk whose byte size, alignment slack included, still fits in a size_t.
+    size_t maxChunkBlocks() const {
+        return (SIZE_MAX - alignment) / blockSize;
+    }
+
+    void countResize(size_t blocks) {
+        POOL_STAT(counters.resizes.fetch_add(1, std::memory_order_relaxed));
+        POOL_STAT(counters.resizeBytes.fetch_add(blocks * blockSize, std::memory_order_relaxed));
+        static_cast<void>(blocks);
+    }
+
+    // Allocates a new region, records it in the chunk registry and makes it the bump chunk. No block is written
+    // here: blocks are carved from the tail on demand and only reach a free list once they have been freed, so
+    // growth is O(1) and pages are first touched when the memory is actually handed out.
+    Chunk* addChunk(size_t blockCount, size_t reservedBlocks = 0) {
+        return linkChunk(createChunk(blockCount, reservedBlocks));
+    }
+
+    // The allocating half of addChunk(): touches no pool state, so it can run without the lock.
+    Chunk* createChunk(size_t blockCount, size_t reservedBlocks = 0) {
+        if (blockCount > maxChunkBlocks()) {
+            throw std::bad_alloc();
+        }
+
+        Region region = allocateRegion(blockSize * blockCount + alignment - 1, backing, prefault, numaNode);
+        POOL_STAT(counters.unboundChunks.fetch_add(region.unbound, std::memory_order_relaxed));
+        Chunk* chunk = wrapRegion(region, static_cast<char*>(alignPointer(region.base, alignment)), blockCount, reservedBlocks);
+
+        resetChecks(chunk);
+        return chunk;
+    }
+
+    // Chunk bookkeeping for blockCount blocks at start, inside region; the check bitmap starts out clear. Also
+    // registers the chunk in the page map.
+    Chunk* wrapRegion(const Region& region, char* start, size_t blockCount, size_t reservedBlocks) {
+        Chunk* chunk = new Chunk;
+        chunk->region = region;
+        chunk->start = start;
+        chunk->end = chunk->start + blockCount * blockSize;
+        chunk->blockCount = blockCount;
+        chunk->bumpIndex.store(reservedBlocks, std::memory_order_relaxed); // Claimed before anyone else can see it
+        chunk->freeCount = 0;
+        chunk->allocatedBits = nullptr;
+        chunk->ownerSlots = nullptr;
+        chunk->owner = this;
+        chunk->ownerKind = &Kind;
+
+        if (remoteFree) {
+            chunk->ownerSlots = new uint8_t[blockCount];
+            std::memset(chunk->ownerSlots, NoOwnerSlot, blockCount);
+        }
+
+        if constexpr (CheckPolicy::Enabled) {
+            chunk->allocatedBits = new std::atomic<uint64_t>[(blockCount + 63) / 64]();
+        }
+
+        // Nothing can point into the chunk until it is linked, so the page map can be filled before the lock
+        pageMap.assign(chunk->start, chunk->end - chunk->start, chunk);
+        return chunk;
+    }
+
+    // The publishing half of addChunk(); called with the lock held.
+    Chunk* linkChunk(Chunk* chunk) {
+        chunk->next = chunks;
+        chunks = chunk;
+        totalBlocks.fetch_add(chunk->blockCount, std::memory_order_relaxed);
+
+        bumpChunk.store(chunk, std::memory_order_release);
+
+        return chunk;
+    }
+
+    // Claims up to `wanted` consecutive blocks from the bump chunk's tail and pushes them onto `head`, lowest
+    // address on top. Uses a CAS so lock-free pools can call it without holding the lock. An exhausted bump chunk
+    // hands over to the next chunk in the registry, which only has a tail left after reset(); a chunk's next link
+    // never changes once it is published, so lock-free callers can follow it too.
+    size_t takeTail(size_t wanted, Block*& head) {
+        Chunk* chunk = bumpChunk.load(std::memory_order_acquire);
+        size_t index;
+        size_t taken = 0;
+
+        while (chunk && (taken = claimTail(chunk, 1, wanted, index)) == 0) {
+            if (chunk->next == nullptr) {
+                return 0;
+            }
+
+            if (bumpChunk.compare_exchange_strong(chunk, chunk->next, std::memory_order_acq_rel)) {
+                chunk = chunk->next;
+            } // Otherwise chunk now holds wherever another thread moved the cursor
+        }
+
+        if (!chunk) {
+            return 0;
+        }
+
+        for (size_t i = taken; i > 0; i--) {
+            Block* block = reinterpret_cast<Block*>(chunk->start + (index + i - 1) * blockSize);
+            block->next = head;
+            head = block;
+        }
+
+        return taken;
+    }
+
+    // Advances the chunk's bump index by up to `wanted` blocks, or by nothing if fewer than `minimum` remain.
+    // Returns the number claimed and their first index.
+    static size_t claimTail(Chunk* chunk, size_t minimum, size_t wanted, size_t& index) {
+        index = chunk->bumpIndex.load(std::memory_order_relaxed);
+        size_t taken;
+
+        do {
+            size_t remaining = chunk->blockCount - index;
+
+            if (remaining < minimum) {
+                return 0;
+            }
+            taken = remaining < wanted ? remaining : wanted;
+        } while (!chunk->bumpIndex.compare_exchange_weak(index, index + taken, std::memory_order_relaxed));
+
+        return taken;
+    }
+
+    // Pushes a chain onto the shared free list; the caller already holds the lock in Locked mode.
+    void spliceLocked(Block* first, Block* last) {
+        if (strategy == FreeListStrategy::LockFree) {
+            lockFreeList.pushChain(first, last);
+            return;
+        }
+
+        last->next = freeList;
+        freeList = first;
+    }
+
+    Chunk* findChunk(const void* ptr) const {
+        Chunk* chunk = chunkFor(ptr);
+        return chunk != nullptr && chunk->owner == this ? chunk : nullptr;
+    }
+
+    // Chunk of any pool whose blocks contain ptr.
+    static Chunk* chunkFor(const void* ptr) {
+        Chunk* chunk = pageMap.lookup(ptr);
+        const char* p = static_cast<const char*>(ptr);
+
+        if (chunk == nullptr || p < chunk->start || p >= chunk->end) {
+            return nullptr;
+        }
+        return chunk;
+    }
+
+    void releaseChunk(Chunk* chunk) {
+        pageMap.assign(chunk->start, chunk->end - chunk->start, nullptr);
+        releaseRegion(chunk->region);
+        delete[] chunk->allocatedBits;
+        delete[] chunk->ownerSlots;
+        delete chunk;
+    }
+
+    // Marks every block of the chunk free again and, with poisoning, fills the whole chunk with the pattern so
+    // blocks carved from the tail pass the same check as recycled ones. That touches every page up front.
+    void resetChecks(Chunk* chunk) {
+        if constexpr (CheckPolicy::Enabled) {
+            for (size_t word = 0; word < (chunk->blockCount + 63) / 64; word++) {
+                chunk->allocatedBits[word].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        if constexpr (CheckPolicy::Poison) {
+            std::memset(chunk->start, PoisonByte, chunk->blockCount * blockSize);
+        }
+        static_cast<void>(chunk);
+    }
+
+    // Finds the chunk and index of a block for the checks, or returns nullptr if ptr isn't the start of one.
+    Chunk* locateBlock(const Block* block, size_t& index) {
+        Chunk* chunk = findChunk(block);
+
+        if (chunk == nullptr) {
+            return nullptr;
+        }
+
+        size_t offset = reinterpret_cast<const char*>(block) - chunk->start;
+        index = offset / blockSize;
+        return offset % blockSize == 0 ? chunk : nullptr;
+    }
+
+    // Checked pools: records the block as handed out, verifies its poison and arms its canary. The first word is
+    // left out of the poison check because the free lists keep their link there.
+    Block* checkAllocate(Block* block) {
+        if constexpr (CheckPolicy::Enabled) {
+            size_t index;
+            Chunk* chunk = locateBlock(block, index);
+
+            if (chunk == nullptr) {
+                throw std::logic_error("Free list is corrupt: it points outside the pool");
+            }
+
+            uint64_t bit = uint64_t(1) << (index % 64);
+
+            if (chunk->allocatedBits[index / 64].fetch_or(bit, std::memory_order_relaxed) & bit) {
+                throw std::logic_error("Free list is corrupt: block handed out twice");
+            }
+
+            if constexpr (CheckPolicy::Poison) {
+                const unsigned char* bytes = reinterpret_cast<const unsigned char*>(block);
+
+                for (size_t i = sizeof(Block); i < userSize; i++) {
+                    if (bytes[i] != PoisonByte) {
+                        throw std::logic_error("Block was written after it was freed");
+                    }
+                }
+            }
+
+            std::memcpy(reinterpret_cast<char*>(block) + userSize, &GuardCanary, CanarySize);
+        }
+        return block;
+    }
+
+    // Checked pools: rejects foreign pointers, double frees and blocks whose canary was overwritten, then poisons.
+    void checkDeallocate(Block* block) {
+        if constexpr (CheckPolicy::Enabled) {
+            size_t index;
+            Chunk* chunk = locateBlock(block, index);
+
+            if (chunk == nullptr) {
+                throw std::invalid_argument("Block does not belong to this pool");
+            }
+
+            std::atomic<uint64_t>& word = chunk->allocatedBits[index / 64];
+            uint64_t bit = uint64_t(1) << (index % 64);
+
+            if (!(word.load(std::memory_order_relaxed) & bit)) {
+                throw std::logic_error("Double free of a pool block");
+            }
+
+            if (std::memcmp(reinterpret_cast<char*>(block) + userSize, &GuardCanary, CanarySize) != 0) {
+                throw std::logic_error("Block overflow: guard canary overwritten");
+            }
+
+            if (!(word.fetch_and(~bit, std::memory_order_relaxed) & bit)) {
+                throw std::logic_error("Double free of a pool block");
+            }
+
+            if constexpr (CheckPolicy::Poison) {
+                std::memset(reinterpret_cast<char*>(block) + sizeof(Block), PoisonByte, userSize - sizeof(Block));
+            }
+        }
+        static_cast<void>(block);
+    }
+
+    void destroyMemoryPool() {
+        while (chunks != nullptr) {
+            Chunk* chunk = chunks;
+            chunks = chunk->next;
+            releaseChunk(chunk);
+        }
+        this->poolStart = nullptr;
+        this->freeList = nullptr;
+        this->totalBlocks.store(0, std::memory_order_relaxed);
+    }  
+};
+
+// The pool every other component in this file is built on. Single-threaded users can pick
+// BasicMemoryPool<NullLock> to drop the locking entirely, and BasicMemoryPool<Spinlock, DebugChecks<>> checks
+// every block handed in and out.
+using MemoryPool = BasicMemoryPool<>;
+
+// Fixed-capacity pool of N slots for T, stored inline in the object, so it can live on the stack or in static
+// storage and never touches the heap. Sizes and alignment are compile-time constants, so slot addressing folds
+// to constant offsets and every call inlines. Not synchronized: use one per thread, or guard it externally.
+template<typename T, size_t N, size_t Align = alignof(T)>
+class FixedPool {
+    static_assert(N > 0, "FixedPool needs at least one slot");
+    static_assert(Align != 0 && (Align & (Align - 1)) == 0, "Alignment must be a power of two");
+    static_assert(Align >= alignof(T), "Alignment must satisfy alignof(T)");
+
+private:
+    union Slot {
+        Slot* next; // Valid only while the slot is free
+        alignas(Align) unsigned char bytes[sizeof(T)];
+    };
+
+    Slot slots[N];
+    Slot* freeList = nullptr; // Slots that were freed; untouched ones are handed out by bump first
+    size_t bumpIndex = 0;
+
+public:
+    static constexpr size_t SlotSize = sizeof(Slot);
+
+    FixedPool() = default;
+    FixedPool(const FixedPool&) = delete;
+    FixedPool& operator=(const FixedPool&) = delete;
+
+    static constexpr size_t capacity() {
+        return N;
+    }
+
+    // Uninitialized storage for one T, or nullptr when all N slots are in use.
+    T* allocate() {
+        Slot* slot = freeList;
+
+        if (slot != nullptr) {
+            freeList = slot->next;
+        }
+        else if (bumpIndex < N) {
+            slot = &slots[bumpIndex++];
+        }
+        else {
+            return nullptr;
+        }
+        return reinterpret_cast<T*>(slot->bytes);
+    }
+
+    void deallocate(T* ptr) {
+        Slot* slot = reinterpret_cast<Slot*>(ptr);
+        slot->next = freeList;
+        freeList = slot;
+    }
+
+    template<typename... Args>
+    T* create(Args&&... args) {
+        T* storage = allocate();
+        return storage != nullptr ? new (storage) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    void destroy(T* object) {
+        object->~T();
+        deallocate(object);
+    }
+
+    bool owns(const T* ptr) const {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(ptr);
+        const unsigned char* begin = reinterpret_cast<const unsigned char*>(slots);
+        return p >= begin && p < begin + sizeof(slots);
+    }
+};
+
+// std::pmr adapter: requests that fit in one block come from the pool, anything larger or more aligned goes to
+// the upstream resource. The same size and alignment test picks the path on deallocation.
+class PoolMemoryResource : public std::pmr::memory_resource {
+private:
+    MemoryPool* pool;
+    std::pmr::memory_resource* upstream;
+
+public:
+    explicit PoolMemoryResource(MemoryPool* memoryPool, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : pool(memoryPool), upstream(upstream) {}
+
+    MemoryPool* getPool() const {
+        return pool;
+    }
+
+private:
+    bool fitsInBlock(size_t bytes, size_t alignment) const {
+        return bytes <= pool->getBlockSize() && alignment <= pool->getAlignment();
+    }
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        if (!fitsInBlock(bytes, alignment)) {
+            return upstream->allocate(bytes, alignment);
+        }
+
+        Block* block = pool->allocateBlock();
+
+        if (!block) {
+            throw std::bad_alloc();
+        }
+        return block;
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        if (!fitsInBlock(bytes, alignment)) {
+            upstream->deallocate(ptr, bytes, alignment);
+            return;
+        }
+        pool->deallocateBlock(static_cast<Block*>(ptr));
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        const PoolMemoryResource* resource = dynamic_cast<const PoolMemoryResource*>(&other);
+        return resource != nullptr && resource->pool == pool && resource->upstream->is_equal(*upstream);
+    }
+};
+
+// Allocator over a MemoryPool for standard containers. Containers rebind it to their node type, and each
+// rebound type re-checks its own size and alignment against the pool: a single object that fits a block comes
+// from the pool, while arrays (bucket tables, vectors) and oversized nodes fall back to operator new. Size the
+// pool's blockSize to the container's node to keep every node in the pool.
+template<typename T>
+class PoolAllocator {
+private:
+    MemoryPool* pool;
+
+public:
+    using value_type = T;
+
+    template<typename U>
+    struct rebind {
+        using other = PoolAllocator<U>;
+    };
+
+    explicit PoolAllocator(MemoryPool* memoryPool) noexcept : pool(memoryPool) {}
+
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept : pool(other.getPool()) {}
+
+    T* allocate(size_t n) {
+        if (fitsInBlock(n)) {
+            Block* block = pool->allocateBlock();
+
+            if (!block) {
+                throw std::bad_alloc();
+            }
+            return reinterpret_cast<T*>(block);
+        }
+
+        if (n > static_cast<size_t>(-1) / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        if (fitsInBlock(n)) {
+            pool->deallocateBlock(reinterpret_cast<Block*>(ptr));
+            return;
+        }
+        operator delete(ptr, std::align_val_t(alignof(T)));
+    }
+
+    MemoryPool* getPool() const noexcept {
+        return pool;
+    }
+
+    bool fitsInBlock(size_t n) const noexcept {
+        return n == 1 && sizeof(T) <= pool->getBlockSize() && alignof(T) <= pool->getAlignment();
+    }
+
+    template<typename U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept {
+        return pool == other.getPool();
+    }
+
+    template<typename U>
+    bool operator!=(const PoolAllocator<U>& other) const noexcept {
+        return pool != other.getPool();
+    }
+};
+
+// Routes variable-sized requests to one MemoryPool per size class. Classes grow geometrically with four
+// steps per power of two (16, 32, 48, 64, 80, 96, 112, 128, 160, ... 4096), so internal waste stays under 25%,
+// and a byte table indexed by size / 16 finds the class in O(1). Larger requests go to operator new.
+class SizeClassAllocator {
+public:
+    static constexpr size_t MaxSmallSize = 4096;
+    static constexpr size_t SizeClassCount = 28;
+    static constexpr size_t LookupGranularity = 16;
+
+private:
+    MemoryPool* pools[SizeClassCount];
+    size_t classSizes[SizeClassCount];
+    uint8_t classIndex[MaxSmallSize / LookupGranularity + 1]; // (size + 15) / 16 -> size class
+
+public:
+    // initialBytesPerClass is only reserved, not touched, so unused classes cost no RSS.
+    SizeClassAllocator(size_t initialBytesPerClass = 64 * 1024) {
+        size_t count = 0;
+
+        for (size_t size = LookupGranularity; size <= 64; size += LookupGranularity) {
+            classSizes[count++] = size;
+        }
+
+        for (size_t base = 64; base < MaxSmallSize; base *= 2) {
+            for (size_t step = 1; step <= 4; step++) {
+                classSizes[count++] = base + step * (base / 4);
+            }
+        }
+
+        size_t current = 0;
+
+        for (size_t slot = 0; slot <= MaxSmallSize / LookupGranularity; slot++) {
+            while (classSizes[current] < slot * LookupGranularity) {
+                current++;
+            }
+            classIndex[slot] = static_cast<uint8_t>(current);
+        }
+
+        for (size_t i = 0; i < SizeClassCount; i++) {
+            size_t blocks = initialBytesPerClass / classSizes[i];
+            pools[i] = new MemoryPool(classSizes[i], blocks > 0 ? blocks : 1, LookupGranularity);
+        }
+    }
+
+    ~SizeClassAllocator() {
+        for (MemoryPool* pool : pools) {
+            delete pool;
+        }
+    }
+
+    SizeClassAllocator(const SizeClassAllocator&) = delete;
+    SizeClassAllocator& operator=(const SizeClassAllocator&) = delete;
+
+    void* allocate(size_t size) {
+        if (size > MaxSmallSize) {
+            return operator new(size);
+        }
+        return pools[classOf(size)]->allocateBlock();
+    }
+
+    // Frees without the size: the PageMap finds the pool the block came from, and anything no pool owns was a
+    // large request from operator new.
+    void deallocate(void* ptr) {
+        if (ptr == nullptr) {
+            return;
+        }
+
+        if (MemoryPool* pool = MemoryPool::ownerOf(ptr)) {
+            pool->deallocateBlock(static_cast<Block*>(ptr));
+            return;
+        }
+        operator delete(ptr);
+    }
+
+    // size must be the value passed to allocate(); it selects the pool the block came from without a lookup.
+    void deallocate(void* ptr, size_t size) {
+        if (ptr == nullptr) {
+            return;
+        }
+
+        if (size > MaxSmallSize) {
+            operator delete(ptr);
+            return;
+        }
+        pools[classOf(size)]->deallocateBlock(static_cast<Block*>(ptr));
+    }
+
+    // Number of bytes actually reserved for a request of the given size.
+    size_t roundedSize(size_t size) const {
+        return size > MaxSmallSize ? size : classSizes[classOf(size)];
+    }
+
+    MemoryPool& poolFor(size_t size) {
+        return *pools[classOf(size)];
+    }
+
+private:
+    size_t classOf(size_t size) const {
+        if (size == 0) {
+            size = 1; // Zero-byte requests still get a distinct block
+        }
+        return classIndex[(size + LookupGranularity - 1) / LookupGranularity];
+    }
+};
+
+size_t numaNodeCount() {
+#ifdef _WIN32
+    ULONG highest = 0;
+    return GetNumaHighestNodeNumber(&highest) ? highest + 1 : 1;
+#else
+    // /sys lists online nodes as ranges such as "0" or "0-1,3"; the highest id bounds the node count.
+    std::FILE* file = std::fopen("/sys/devices/system/node/online", "r");
+    size_t highest = 0;
+
+    if (file != nullptr) {
+        unsigned long id;
+        char separator;
+
+        while (std::fscanf(file, "%lu", &id) == 1) {
+            highest = id > highest ? id : highest;
+
+            if (std::fscanf(file, "%c", &separator) != 1) {
+                break;
+            }
+        }
+        std::fclose(file);
+    }
+    return highest + 1;
+#endif
+}
+
+int currentNumaNode() {
+#ifdef _WIN32
+    PROCESSOR_NUMBER processor;
+    USHORT node = 0;
+    GetCurrentProcessorNumberEx(&processor);
+    GetNumaProcessorNodeEx(&processor, &node);
+    return node;
+#elif defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu = 0;
+    unsigned node = 0;
+    syscall(SYS_getcpu, &cpu, &node, nullptr);
+    return static_cast<int>(node);
+#else
+    return 0;
+#endif
+}
+
+// One MemoryPool per NUMA node, each with its chunks bound to that node. Allocations come from the calling
+// thread's node and only spill to other nodes when the local pool can't provide a block. Frees are routed back
+// to the pool that owns the block, so memory never migrates between nodes' free lists.
+class NumaMemoryPool {
+private:
+    static constexpr unsigned NodeRefreshInterval = 256; // Allocations between re-reading the current node
+
+    MemoryPool** pools;
+    size_t nodeCount;
+
+public:
+    NumaMemoryPool(size_t blockSize, size_t blocksPerNode, size_t alignment = alignof(std::max_align_t),
+                   PoolOptions options = PoolOptions{}) {
+        nodeCount = numaNodeCount();
+        pools = new MemoryPool*[nodeCount];
+
+        for (size_t node = 0; node < nodeCount; node++) {
+            options.numaNode = static_cast<int>(node);
+            pools[node] = new MemoryPool(blockSize, blocksPerNode, alignment, options);
+        }
+    }
+
+    ~NumaMemoryPool() {
+        for (size_t node = 0; node < nodeCount; node++) {
+            delete pools[node];
+        }
+        delete[] pools;
+    }
+
+    NumaMemoryPool(const NumaMemoryPool&) = delete;
+    NumaMemoryPool& operator=(const NumaMemoryPool&) = delete;
+
+    Block* allocateBlock() {
+        size_t local = localNode();
+        Block* block = pools[local]->allocateBlock();
+
+        for (size_t i = 1; block == nullptr && i < nodeCount; i++) {
+            block = pools[(local + i) % nodeCount]->allocateBlock();
+        }
+        return block;
+    }
+
+    void deallocateBlock(Block* block) {
+        MemoryPool* owner = MemoryPool::ownerOf(block);
+
+        for (size_t node = 0; node < nodeCount; node++) {
+            if (pools[node] == owner) {
+                owner->deallocateBlock(block);
+                return;
+            }
+        }
+        throw std::invalid_argument("Block does not belong to this NumaMemoryPool");
+    }
+
+    size_t getNodeCount() const {
+        return nodeCount;
+    }
+
+    MemoryPool& poolForNode(size_t node) {
+        return *pools[node];
+    }
+
+private:
+    // getcpu is a syscall, so the node is cached per thread and refreshed periodically to follow migrations.
+    size_t localNode() const {
+        thread_local unsigned calls = 0;
+        thread_local int node = 0;
+
+        if (calls++ % NodeRefreshInterval == 0) {
+            node = currentNumaNode();
+        }
+        return static_cast<size_t>(node) < nodeCount ? static_cast<size_t>(node) : 0;
+    }
+};
+
+// Epoch-based deferred reclamation for structures whose readers traverse pool blocks without locks. Readers
+// hold an EpochGuard while they touch shared blocks; writers unlink a block and retire() it instead of freeing it.
+// A block retired in epoch e is freed once the global epoch reaches e + 2, by which point every reader that could
+// have seen it has left its guard. Each thread slot keeps three buckets, one per live epoch, and safe buckets go
+// back to the pool in one deallocateChain(). Retired blocks are never written before they are safe, since
+// readers may still be following the links stored in them.
+class EpochReclaimer {
+private:
+    static constexpr uint64_t Quiescent = 0; // Epochs start at 1, so 0 marks a participant outside any guard
+    static constexpr size_t CollectThreshold = 64; // Retires between attempts to advance the epoch
+
+    struct RetireBuckets {
+        std::vector<Block*> blocks[3]; // Indexed by epoch % 3
+        uint64_t epochs[3] = {};
+        size_t pending = 0;
+    };
+
+    struct alignas(CacheLineSize) Participant {
+        std::atomic<uint64_t> epoch{Quiescent};
+        unsigned nesting = 0;
+        RetireBuckets retired;
+    };
+
+    MemoryPool* pool;
+    alignas(CacheLineSize) std::atomic<uint64_t> globalEpoch{1};
+    std::atomic<size_t> unslottedReaders{0}; // Threads without a slot can't announce an epoch, so they pin it
+    Participant participants[MaxThreadSlots];
+    Spinlock orphanLock;
+    RetireBuckets orphans; // Retired by threads without a slot
+
+public:
+    explicit EpochReclaimer(MemoryPool* memoryPool) : pool(memoryPool) {}
+
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+    // Guards nest; only the outermost one announces and clears the epoch. Returns the slot to pass to exit().
+    size_t enter() {
+        size_t slot = ThreadSlot::current();
+
+        if (slot == NoThreadSlot) {
+            unslottedReaders.fetch_add(1, std::memory_order_seq_cst);
+            return slot;
+        }
+
+        Participant& participant = participants[slot];
+
+        if (participant.nesting++ == 0) {
+            // The fence keeps the reader's loads of the structure from being satisfied before the announcement
+            // is visible to tryAdvance(); a seq_cst store alone doesn't order later acquire loads.
+            participant.epoch.store(globalEpoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+        return slot;
+    }
+
+    void exit(size_t slot) {
+        if (slot == NoThreadSlot) {
+            unslottedReaders.fetch_sub(1, std::memory_order_release);
+            return;
+        }
+
+        Participant& participant = participants[slot];
+
+        if (--participant.nesting == 0) {
+            participant.epoch.store(Quiescent, std::memory_order_release);
+        }
+    }
+
+    // Takes ownership of a block that is no longer reachable from the shared structure. It may be called inside
+    // or outside a guard.
+    void retire(Block* block) {
+        size_t slot = ThreadSlot::current();
+
+        if (slot == NoThreadSlot) {
+            orphanLock.lockPool();
+            stash(orphans, block);
+            bool collectNow = orphans.pending >= CollectThreshold;
+            orphanLock.unlockPool();
+
+            if (collectNow) {
+                collect();
+            }
+            return;
+        }
+
+        RetireBuckets& retired = participants[slot].retired;
+        stash(retired, block);
+
+        if (retired.pending >= CollectThreshold) {
+            collect();
+        }
+    }
+
+    // Advances the epoch if every reader has caught up with it and frees the calling thread's buckets that are
+    // now safe. Returns how many blocks went back to the pool.
+    size_t collect() {
+        tryAdvance();
+
+        size_t slot = ThreadSlot::current();
+
+        if (slot == NoThreadSlot) {
+            orphanLock.lockPool();
+            size_t freed = freeSafe(orphans);
+            orphanLock.unlockPool();
+            return freed;
+        }
+        return freeSafe(participants[slot].retired);
+    }
+
+    uint64_t getEpoch() const {
+        return globalEpoch.load(std::memory_order_relaxed);
+    }
+
+    // Frees everything still retired; no reader may be inside a guard.
+    ~EpochReclaimer() {
+        for (Participant& participant : participants) {
+            freeAll(participant.retired);
+        }
+        freeAll(orphans);
+    }
+
+private:
+    // Files block under the current epoch. A bucket still stamped with an older epoch is at least three epochs
+    // old and so already safe; it is freed before the bucket is reused.
+    void stash(RetireBuckets& retired, Block* block) {
+        uint64_t epoch = globalEpoch.load(std::memory_order_seq_cst);
+        size_t bucket = epoch % 3;
+
+        if (retired.epochs[bucket] != epoch) {
+            freeBucket(retired, bucket);
+            retired.epochs[bucket] = epoch;
+        }
+        retired.blocks[bucket].push_back(block);
+        retired.pending++;
+    }
+
+    bool tryAdvance() {
+        uint64_t epoch = globalEpoch.load(std::memory_order_seq_cst);
+
+        if (unslottedReaders.load(std::memory_order_seq_cst) != 0) {
+            return false;
+        }
+
+        for (const Participant& participant : participants) {
+            uint64_t announced = participant.epoch.load(std::memory_order_seq_cst);
+
+            if (announced != Quiescent && announced != epoch) {
+                return false;
+            }
+        }
+        return globalEpoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+    }
+
+    size_t freeSafe(RetireBuckets& retired) {
+        uint64_t epoch = globalEpoch.load(std::memory_order_seq_cst);
+        size_t freed = 0;
+
+        for (size_t bucket = 0; bucket < 3; bucket++) {
+            if (retired.epochs[bucket] + 2 <= epoch) {
+                freed += freeBucket(retired, bucket);
+            }
+        }
+        return freed;
+    }
+
+    size_t freeAll(RetireBuckets& retired) {
+        size_t freed = 0;
+
+        for (size_t bucket = 0; bucket < 3; bucket++) {
+            freed += freeBucket(retired, bucket);
+        }
+        return freed;
+    }
+
+    // Links the bucket's blocks into a chain, which is safe now that no reader can reach them.
+    size_t freeBucket(RetireBuckets& retired, size_t bucket) {
+        std::vector<Block*>& blocks = retired.blocks[bucket];
+        size_t count = blocks.size();
+
+        if (count == 0) {
+            return 0;
+        }
+
+        for (size_t i = 0; i + 1 < count; i++) {
+            blocks[i]->next = blocks[i + 1];
+        }
+        pool->deallocateChain(blocks.front(), blocks.back(), count);
+
+        blocks.clear();
+        retired.pending -= count;
+        return count;
+    }
+};
+
+// Scoped EpochReclaimer::enter()/exit().
+class EpochGuard {
+private:
+    EpochReclaimer& reclaimer;
+    size_t slot;
+
+public:
+    explicit EpochGuard(EpochReclaimer& epochReclaimer) : reclaimer(epochReclaimer), slot(epochReclaimer.enter()) {}
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+
+    ~EpochGuard() {
+        reclaimer.exit(slot);
+    }
+};
+
+// Layout of a SingleLinkedList snapshot file: this header, padded to SnapshotHeaderBytes, then nodeCount blocks of
+// blockStride bytes copied verbatim, except that each Node::next holds the byte offset of the next node's block
+// from the first block, or SnapshotNullOffset. Native byte order; pointerSize rejects files from other ABIs.
+struct SnapshotHeader {
+    char magic[8];
+    uint64_t pointerSize;
+    uint64_t blockSize;
+    uint64_t blockStride;
+    uint64_t nodeCount;
+    uint64_t headOffset;
+};
+
+constexpr char SnapshotMagic[8] = {'M', 'P', 'L', 'S', 'N', 'A', 'P', '1'};
+constexpr size_t SnapshotHeaderBytes = 4096; // Keeps the blocks page aligned when the file is mapped
+constexpr uintptr_t SnapshotNullOffset = ~uintptr_t(0);
+
+class SingleLinkedList {
+private:
+    // How many blocks ahead of the current node walks prefetch. Nodes that were allocated in order or compact()ed
+    // sit one stride apart, so that guess is usually the node the walk reaches PrefetchDistance hops later.
+    static constexpr size_t PrefetchDistance = 8;
+    static constexpr size_t MaxSortRuns = 64; // Most runs parallelMergeSort() sorts at once, one per thread
+    static constexpr size_t MinSortRun = size_t(1) << 14; // Shorter runs don't repay starting a thread
+
+    Spinlock spinlock;
+    Node* head; // Pointer to the head node
+    Node* tail; // Pointer to the last node so appends don't walk the list
+    size_t length; // Cached node count
+    MemoryPool* pool;
+    size_t prefetchReach; // PrefetchDistance block strides, in bytes
+public:
+    SingleLinkedList(MemoryPool* memoryPool) : head(nullptr), tail(nullptr), length(0), pool(memoryPool),
+        prefetchReach(PrefetchDistance * memoryPool->getBlockStride()) {}
+
+    // Calls visit(data) for every node in list order, prefetching ahead of the walk. visit may change the value
+    // but must not insert or remove nodes.
+    template<typename Visitor>
+    void forEach(Visitor&& visit) {
+        for (Node* current = head; current != nullptr; current = current->next) {
+            prefetchFrom(current);
+            visit(current->data);
+        }
+    }
+
+    template<typename Visitor>
+    void forEach(Visitor&& visit) const {
+        for (const Node* current = head; current != nullptr; current = current->next) {
+            prefetchFrom(current);
+            visit(static_cast<const int&>(current->data));
+        }
+    }
+
+    int getLength() {
+        return static_cast<int>(length);
+    }
+
+    Node* getHead() const {
+        return head;
+    }
+
+    Node* getTail() const {
+        return tail;
+    }
+
+    // Returns false when the pool could not provide a node.
+    bool insert(int value) {
+        Node* newNode = createNode(value);
+
+        if (!newNode) {
+            return false;
+        }
+
+        if (head == nullptr) { // If the list is empty
+            head = newNode; // Set the head to the new node
+        }
+        else {
+            tail->next = newNode; // Link the last node to the new node
+        }
+        tail = newNode;
+        length++;
+
+        return true;
+    }
+
+    Node* pushFront(int value) {
+        Node* newNode = createNode(value);
+
+        if (!newNode) {
+            return nullptr;
+        }
+
+        newNode->next = head;
+        head = newNode;
+
+        if (tail == nullptr) {
+            tail = newNode;
+        }
+        length++;
+
+        return newNode;
+    }
+
+    // Inserts value right after node, which must belong to this list. Returns the new node so a run of values
+    // can be inserted in order by feeding each result back in.
+    Node* insertAfter(Node* node, int value) {
+        Node* newNode = createNode(value);
+
+        if (!newNode) {
+            return nullptr;
+        }
+
+        newNode->next = node->next;
+        node->next = newNode;
+
+        if (tail == node) {
+            tail = newNode;
+        }
+        length++;
+
+        return newNode;
+    }
+
+    // Appends count values, taking blocks from the pool InsertBatch at a time instead of one lock per node.
+    // Returns how many were inserted, which is less than count only if the pool ran out.
+    size_t insert(const int* values, size_t count) {
+        static constexpr size_t InsertBatch = 64;
+        Block* blocks[InsertBatch];
+
+        Node* last = tail;
+
+        for (size_t done = 0; done < count;) {
+            size_t wanted = count - done < InsertBatch ? count - done : InsertBatch;
+            size_t obtained = pool->allocateBlocks(blocks, wanted);
+
+            for (size_t i = 0; i < obtained; i++) {
+                Node* newNode = new (blocks[i]) Node(values[done + i]);
+
+                if (last == nullptr) {
+                    head = newNode;
+                }
+                else {
+                    last->next = newNode;
+                }
+                last = newNode;
+            }
+            tail = last;
+            length += obtained;
+            done += obtained;
+
+            if (obtained < wanted) {
+                return done;
+            }
+        }
+        return count;
+    }
+
+    // Removes the first node holding value; returns false if there is none.
+    bool remove(int value) {
+        if (head == nullptr) return false;
+
+        Node* current = head;
+        Node* previous = nullptr;
+
+        while (current != nullptr && current->data != value) {
+            previous = current;
+            current = current->next;
+        }
+
+        if (current == nullptr) {
+            return false;
+        }
+
+        if (current == head) { // if the value to be removed is the head node
+            head = head->next; //move head to next node
+        }
+        else {
+            previous->next = current->next; // Bypass the current node
+        }
+
+        if (current == tail) {
+            tail = previous;
+        }
+        length--;
+
+        pool->deallocateBlock(reinterpret_cast<Block*>(current));
+        return true;
+    }
+    
+    Node* merge(Node* left, Node* right) {
+        Node dummy(0);
+        mergeAfter(&dummy, left, right);
+        return dummy.next;
+    }
+
+    // The cached length pins the middle down, so a single walk over half the list finds it; the same node the
+    // slow/fast walk below would return.
+    Node* getMiddle() {
+        if (head == nullptr) {
+            return nullptr;
+        }
+
+        Node* current = head;
+
+        for (size_t i = (length - 1) / 2; i > 0; i--) {
+            prefetchFrom(current);
+            current = current->next;
+        }
+        return current;
+    }
+
+    Node* getMiddle(Node* node) {
+        if (!node || !node->next) {
+            return node;
+        }
+        Node* slow = node;
+        Node* fast = node->next;
+
+        while (fast != nullptr && fast->next != nullptr) {
+            prefetchFrom(fast->next);
+            slow = slow->next;
+            fast = fast->next->next;
+        }
+
+        return slow;
+    }
+
+    // Bottom-up merge sort: merges runs of width 1, 2, 4, ... in place, so it needs no recursion, O(1) extra
+    // space and no slow/fast pointer walks to find midpoints. Stable, like the recursive version it replaces.
+    void mergeSort() {
+        head = sortRuns(head, length, tail);
+    }
+
+    // Splits the list into up to `threads` runs of at least MinSortRun nodes, sorts them concurrently with the
+    // calling thread taking the first, then merges them in one pass through a tournament tree. Stable, like
+    // mergeSort(), which it falls back to for short lists. Relinks the nodes in place, so nothing is allocated
+    // besides the worker threads themselves; 0 threads means one per hardware thread.
+    void parallelMergeSort(size_t threads = 0) {
+        if (threads == 0) {
+            threads = std::thread::hardware_concurrency();
+        }
+
+        size_t runCount = std::min({threads, MaxSortRuns, length / MinSortRun});
+
+        if (runCount < 2) {
+            mergeSort();
+            return;
+        }
+
+        Node* runs[MaxSortRuns];
+        size_t runLengths[MaxSortRuns];
+        Node* rest = head;
+
+        for (size_t i = 0; i < runCount; i++) {
+            runs[i] = rest;
+            runLengths[i] = length / runCount + (i < length % runCount ? 1 : 0);
+            rest = splitAfter(rest, runLengths[i]);
+        }
+
+        std::thread workers[MaxSortRuns];
+
+        for (size_t i = 1; i < runCount; i++) {
+            try {
+                workers[i] = std::thread([this, &runs, &runLengths, i] {
+                    Node* last = nullptr;
+                    runs[i] = sortRuns(runs[i], runLengths[i], last);
+                });
+            }
+            catch (const std::system_error&) { // Out of threads; sort this run here once the first is done
+            }
+        }
+
+        for (size_t i = 0; i < runCount; i++) {
+            if (workers[i].joinable()) {
+                workers[i].join();
+            }
+            else {
+                Node* last = nullptr;
+                runs[i] = sortRuns(runs[i], runLengths[i], last);
+            }
+        }
+
+        head = mergeRuns(runs, runCount, tail);
+    }
+
+    Node* mergeSort(Node* node) {
+        size_t count = 0;
+
+        for (Node* current = node; current != nullptr; current = current->next) {
+            count++;
+        }
+
+        Node* last = nullptr;
+        return sortRuns(node, count, last);
+    }
+
+    void clear() {
+        spinlock.lockPool();
+        releaseNodes();
+        head = nullptr;
+        tail = nullptr;
+        length = 0;
+        spinlock.unlockPool();
+    }
+
+    // Forgets every node without handing it back, for lists whose pool is about to be reset() as a whole; that
+    // reclaims the nodes in one step instead of the walk clear() does. The list is empty and reusable afterwards.
+    void release() {
+        spinlock.lockPool();
+        head = nullptr;
+        tail = nullptr;
+        length = 0;
+        spinlock.unlockPool();
+    }
+
+    // Copies the nodes into one run of consecutive pool blocks in list order and frees the old ones, so later
+    // traversals walk memory sequentially instead of hopping between scattered blocks. Node addresses change.
+    void compact() {
+        if (length < 2) {
+            return;
+        }
+
+        spinlock.lockPool();
+
+        char* cursor = reinterpret_cast<char*>(pool->allocateContiguous(length));
+
+        if (cursor == nullptr) { // The pool may not grow enough for the copy; leave the list as it is
+            spinlock.unlockPool();
+            return;
+        }
+
+        size_t stride = pool->getBlockStride();
+        Node* newHead = nullptr;
+        Node* newTail = nullptr;
+
+        for (Node* current = head; current != nullptr; current = current->next) {
+            Node* copy = new (cursor) Node(current->data);
+            cursor += stride;
+
+            if (newTail == nullptr) {
+                newHead = copy;
+            }
+            else {
+                newTail->next = copy;
+            }
+            newTail = copy;
+        }
+
+        releaseNodes();
+        head = newHead;
+        tail = newTail;
+        spinlock.unlockPool();
+    }
+
+    // Writes the nodes to path in list order, so offsets run sequentially and a loaded list is already compacted.
+    // The data goes to path.tmp first and is renamed over path, so a crash never leaves a torn snapshot and
+    // lists still mapping the previous file keep their pages. Returns false if the file could not be written.
+    bool saveSnapshot(const char* path) const {
+        static constexpr size_t WriteBatch = 1024; // Nodes staged per fwrite
+
+        std::string staging = std::string(path) + ".tmp";
+        std::FILE* file = std::fopen(staging.c_str(), "wb");
+
+        if (file == nullptr) {
+            return false;
+        }
+
+        size_t stride = pool->getBlockStride();
+        SnapshotHeader header{};
+        std::memcpy(header.magic, SnapshotMagic, sizeof(SnapshotMagic));
+        header.pointerSize = sizeof(Node*);
+        header.blockSize = pool->getBlockSize();
+        header.blockStride = stride;
+        header.nodeCount = length;
+        header.headOffset = length > 0 ? 0 : SnapshotNullOffset;
+
+        std::vector<char> buffer(SnapshotHeaderBytes);
+        std::memcpy(buffer.data(), &header, sizeof(header));
+        bool written = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+
+        buffer.resize(WriteBatch * stride);
+        size_t staged = 0;
+        uintptr_t offset = 0;
+
+        for (const Node* current = head; written && current != nullptr; current = current->next) {
+            prefetchFrom(current);
+            char* out = buffer.data() + staged * stride;
+            uintptr_t next = current->next != nullptr ? offset + stride : SnapshotNullOffset;
+
+            std::memcpy(out, current, stride);
+            std::memcpy(out + offsetof(Node, next), &next, sizeof(next));
+            offset += stride;
+
+            if (++staged == WriteBatch) {
+                written = std::fwrite(buffer.data(), stride, staged, file) == staged;
+                staged = 0;
+            }
+        }
+
+        if (written && staged > 0) {
+            written = std::fwrite(buffer.data(), stride, staged, file) == staged;
+        }
+        written = std::fclose(file) == 0 && written;
+
+#ifdef _WIN32
+        if (written) { // rename() won't replace an existing file here; snapshots are never mapped on Windows
+            std::remove(path);
+        }
+#endif
+        if (!written || std::rename(staging.c_str(), path) != 0) {
+            std::remove(staging.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // Replaces the list with one written by saveSnapshot(). The file is mapped copy-on-write and the mapping
+    // handed to the pool as a chunk (see adoptRegion()), so loading is one sequential pass turning offsets back
+    // into pointers rather than an allocation per node; where it can't be mapped it is read into a heap region.
+    // Returns false and leaves the list as it was if the file can't be read, is malformed, or was written from a
+    // pool with a different block layout. A mapped file must not be truncated or rewritten in place while the list
+    // lives; the kernel would drop even the pages already copied, so replace it the way saveSnapshot() does.
+    bool loadSnapshot(const char* path) {
+        std::FILE* file = std::fopen(path, "rb");
+
+        if (file == nullptr) {
+            return false;
+        }
+
+        size_t stride = pool->getBlockStride();
+        SnapshotHeader header;
+        bool valid = std::fread(&header, sizeof(header), 1, file) == 1
+            && std::memcmp(header.magic, SnapshotMagic, sizeof(SnapshotMagic)) == 0
+            && header.pointerSize == sizeof(Node*) && header.blockSize == pool->getBlockSize()
+            && header.blockStride == stride && header.nodeCount <= (SIZE_MAX - SnapshotHeaderBytes) / stride;
+
+        if (!valid || header.nodeCount == 0) {
+            std::fclose(file);
+
+            if (valid) {
+                clear();
+            }
+            return valid;
+        }
+
+        size_t count = static_cast<size_t>(header.nodeCount);
+        Region region = readSnapshot(file, SnapshotHeaderBytes + count * stride);
+        std::fclose(file);
+
+        if (region.base == nullptr) {
+            return false;
+        }
+
+        char* blocks = static_cast<char*>(region.base) + SnapshotHeaderBytes;
+        size_t span = count * stride;
+        auto resolve = [&](uint64_t offset, Node*& node) {
+            node = offset < span && offset % stride == 0 ? reinterpret_cast<Node*>(blocks + offset) : nullptr;
+            return node != nullptr || offset == SnapshotNullOffset;
+        };
+
+        Node* newHead = nullptr;
+        valid = header.headOffset != SnapshotNullOffset && resolve(header.headOffset, newHead);
+        size_t inOrder = 0; // Leading nodes whose next is simply the following block, as saveSnapshot() writes
+
+        for (size_t i = 0; valid && i < count; i++) {
+            Node* node = reinterpret_cast<Node*>(blocks + i * stride);
+            uintptr_t offset;
+            std::memcpy(&offset, &node->next, sizeof(offset));
+
+            if (offset == (i + 1) * stride && i + 1 < count) {
+                node->next = reinterpret_cast<Node*>(blocks + offset);
+                inOrder += inOrder == i;
+            }
+            else {
+                valid = resolve(offset, node->next);
+            }
+        }
+
+        Node* newTail = reinterpret_cast<Node*>(blocks + span - stride);
+        size_t reached = count;
+
+        // Unless the blocks simply chain in order from the first, check that the walk from head reaches every node
+        // exactly once, which also rules out cycles.
+        if (valid && (newHead != reinterpret_cast<Node*>(blocks) || inOrder != count - 1 || newTail->next != nullptr)) {
+            newTail = newHead;
+            reached = 1;
+
+            for (; newTail->next != nullptr && reached <= count; reached++) {
+                newTail = newTail->next;
+            }
+        }
+
+        if (!valid || reached != count || pool->adoptRegion(region, SnapshotHeaderBytes, count) == nullptr) {
+            releaseRegion(region);
+            return false;
+        }
+
+        clear();
+        spinlock.lockPool();
+        head = newHead;
+        tail = newTail;
+        length = count;
+        spinlock.unlockPool();
+        return true;
+    }
+
+    void display() const {
+        forEach([](int value) {
+            std::cout << value << " ";
+        });
+        std::cout << std::endl;
+    }
+
+    ~SingleLinkedList() {
+        spinlock.lockPool();
+        releaseNodes();
+        spinlock.unlockPool();
+    }
+private:
+    Node* sortRuns(Node* list, size_t count, Node*& last) {
+        last = list;
+
+        for (size_t width = 1; width < count; width *= 2) {
+            Node dummy(0);
+            Node* built = &dummy;
+            Node* rest = list;
+
+            while (rest != nullptr) {
+                Node* left = rest;
+                Node* right = splitAfter(left, width);
+                rest = splitAfter(right, width);
+                built = mergeAfter(built, left, right);
+            }
+            list = dummy.next;
+            last = built;
+        }
+        return list;
+    }
+
+    // k-way merge of sorted runs through a loser tree: each internal node holds the run that lost the match
+    // played there, so after the winner's head is taken only the matches on its leaf-to-root path are replayed,
+    // log2(k) comparisons per node. Ties go to the earlier run, which keeps the merge stable.
+    Node* mergeRuns(Node** runs, size_t count, Node*& last) const {
+        size_t leaves = 1;
+
+        while (leaves < count) {
+            leaves *= 2;
+        }
+
+        Node* heads[MaxSortRuns];
+        size_t losers[MaxSortRuns];
+        size_t winners[2 * MaxSortRuns];
+
+        for (size_t i = 0; i < leaves; i++) {
+            heads[i] = i < count ? runs[i] : nullptr; // Padding runs are empty and lose every match
+            winners[leaves + i] = i;
+        }
+
+        // An exhausted run compares greater than everything, so it only wins once every run is drained.
+        auto beats = [&heads](size_t a, size_t b) {
+            if (heads[a] == nullptr || heads[b] == nullptr) {
+                return heads[b] == nullptr && (heads[a] != nullptr || a < b);
+            }
+            return heads[a]->data < heads[b]->data || (heads[a]->data == heads[b]->data && a < b);
+        };
+
+        for (size_t node = leaves - 1; node > 0; node--) {
+            size_t left = winners[2 * node];
+            size_t right = winners[2 * node + 1];
+            bool leftWins = beats(left, right);
+            winners[node] = leftWins ? left : right;
+            losers[node] = leftWins ? right : left;
+        }
+
+        Node dummy(0);
+        Node* out = &dummy;
+        size_t winner = winners[1];
+
+        while (heads[winner] != nullptr) {
+            out->next = heads[winner];
+            out = out->next;
+            heads[winner] = out->next;
+
+            if (heads[winner] != nullptr) {
+                prefetchFrom(heads[winner]);
+            }
+
+            for (size_t node = (leaves + winner) / 2; node > 0; node /= 2) {
+                if (beats(losers[node], winner)) {
+                    std::swap(losers[node], winner);
+                }
+            }
+        }
+
+        out->next = nullptr;
+        last = out;
+        return dummy.next;
+    }
+
+    // Maps the rest of a snapshot file privately, or reads it into a heap region where mapping isn't available.
+    // Returns a null region if the file isn't exactly `bytes` long or can't be read.
+    static Region readSnapshot(std::FILE* file, size_t bytes) {
+#ifndef _WIN32
+        struct stat info;
+
+        if (fstat(fileno(file), &info) != 0 || static_cast<uint64_t>(info.st_size) != bytes) {
+            return Region{nullptr, 0, BackingStore::Mapped};
+        }
+
+        // Every page is about to be written by the fix-up pass, so fault them all in up front.
+        void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | PopulateFlag, fileno(file), 0);
+
+        if (base != MAP_FAILED) {
+            return Region{base, bytes, BackingStore::Mapped};
+        }
+#endif
+        Region region = allocateRegion(bytes, BackingStore::Heap, false);
+
+        if (std::fseek(file, 0, SEEK_SET) != 0 || std::fread(region.base, 1, bytes, file) != bytes
+            || std::fgetc(file) != EOF) {
+            releaseRegion(region);
+            return Region{nullptr, 0, BackingStore::Heap};
+        }
+        return region;
+    }
+
+    // Starts fetching the node's successor and the block prefetchReach bytes on, see PrefetchDistance.
+    void prefetchFrom(const Node* node) const {
+        prefetchRead(node->next);
+        prefetchRead(reinterpret_cast<const char*>(node) + prefetchReach);
+    }
+
+    // Cuts the list after its first n nodes and returns the remainder.
+    Node* splitAfter(Node* node, size_t n) const {
+        for (size_t i = 1; node != nullptr && i < n; i++) {
+            prefetchFrom(node);
+            node = node->next;
+        }
+
+        if (node == nullptr) {
+            return nullptr;
+        }
+
+        Node* rest = node->next;
+        node->next = nullptr;
+        return rest;
+    }
+
+    // Merges two sorted lists behind `out` and returns the last merged node. Both inputs are prefetched, since
+    // either may supply the next node.
+    Node* mergeAfter(Node* out, Node* left, Node* right) const {
+        while (left != nullptr && right != nullptr) {
+            prefetchFrom(left);
+            prefetchFrom(right);
+
+            if (left->data <= right->data) {
+                out->next = left;
+                left = left->next;
+            }
+            else {
+                out->next = right;
+                right = right->next;
+            }
+            out = out->next;
+        }
+
+        out->next = left != nullptr ? left : right;
+
+        while (out->next != nullptr) {
+            prefetchFrom(out->next);
+            out = out->next;
+        }
+        return out;
+    }
+
+    Node* createNode(int value) {
+        Block* block = pool->allocateBlock();
+
+        if (!block) {
+            return nullptr; // Pool is full
+        }
+
+        return new (block) Node(value); // Placement new to construct Node in the allocated block
+    }
+
+    // Rewrites the nodes in place into a Block chain and hands the whole chain back to the pool in one splice.
+    void releaseNodes() {
+        if (head == nullptr) {
+            return;
+        }
+
+        Block* first = reinterpret_cast<Block*>(head);
+        Block* last = nullptr;
+        Node* current = head;
+        size_t count = 0;
+
+        while (current != nullptr) {
+            Node* temp = current;
+            current = current->next; // read next before the Block view overwrites the node
+            temp->~Node();
+
+            Block* block = reinterpret_cast<Block*>(temp);
+            if (last != nullptr) {
+                last->next = block;
+            }
+            last = block;
+            count++;
+        }
+        pool->deallocateChain(first, last, count);
+    }
+};
+
+// Node of ConcurrentLinkedList, carrying its own lock; still 16 bytes on 64-bit targets. next is atomic and
+// removed is set before unlinking so lock-free readers can walk the list and skip nodes on their way out.
+struct ConcurrentNode {
+    std::atomic<ConcurrentNode*> next;
+    int data;
+    Spinlock lock;
+    std::atomic<bool> removed;
+
+    ConcurrentNode(int value) : next(nullptr), data(value), removed(false) {}
+};
+
+// Sorted list that is safe to share between threads, using hand-over-hand locking: a thread locks the next node
+// before releasing the one it holds, so threads working on different parts of the list never contend and there
+// is no list-wide lock. Unlinking a node takes both its predecessor's lock and its own, which waits out any
+// thread still inside it and stops new ones reaching it, so removed blocks go straight back with
+// deallocateBlock(). Duplicates are allowed; remove() takes out the first match.
+//
+// Given an EpochReclaimer, contains() takes no locks at all: it walks the list inside an EpochGuard, and removed
+// nodes are retired rather than freed so a reader still standing on one stays safe.
+class ConcurrentLinkedList {
+private:
+    ConcurrentNode head; // Sentinel; its lock guards the first link
+    std::atomic<size_t> length;
+    MemoryPool* pool;
+    EpochReclaimer* reclaimer;
+public:
+    ConcurrentLinkedList(MemoryPool* memoryPool, EpochReclaimer* epochReclaimer = nullptr)
+        : head(0), length(0), pool(memoryPool), reclaimer(epochReclaimer) {}
+
+    ConcurrentLinkedList(const ConcurrentLinkedList&) = delete;
+    ConcurrentLinkedList& operator=(const ConcurrentLinkedList&) = delete;
+
+    int getLength() const {
+        return static_cast<int>(length.load(std::memory_order_relaxed));
+    }
+
+    // Links value in before the first node not less than it. Returns false if the pool is out.
+    bool insert(int value) {
+        Block* block = pool->allocateBlock();
+
+        if (!block) {
+            return false;
+        }
+
+        ConcurrentNode* newNode = new (block) ConcurrentNode(value);
+        ConcurrentNode* previous = lockBefore(value);
+
+        newNode->next.store(previous->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        previous->next.store(newNode, std::memory_order_release);
+        previous->lock.unlockPool();
+
+        length.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool remove(int value) {
+        ConcurrentNode* previous = lockBefore(value);
+        ConcurrentNode* current = previous->next.load(std::memory_order_relaxed);
+
+        if (current == nullptr || current->data != value) {
+            previous->lock.unlockPool();
+            return false;
+        }
+
+        current->lock.lockPool();
+        unlinkAfter(previous, current);
+        current->lock.unlockPool();
+        previous->lock.unlockPool();
+
+        length.fetch_sub(1, std::memory_order_relaxed);
+        releaseNode(current);
+        return true;
+    }
+
+    bool contains(int value) {
+        if (reclaimer != nullptr) {
+            EpochGuard guard(*reclaimer);
+            ConcurrentNode* current = head.next.load(std::memory_order_acquire);
+
+            // A removed copy may have a live duplicate behind it, so removed nodes equal to value are skipped too
+            while (current != nullptr && (current->data < value
+                       || (current->data == value && current->removed.load(std::memory_order_acquire)))) {
+                current = current->next.load(std::memory_order_acquire);
+            }
+            return current != nullptr && current->data == value;
+        }
+
+        ConcurrentNode* previous = lockBefore(value);
+        ConcurrentNode* current = previous->next.load(std::memory_order_relaxed);
+        bool found = current != nullptr && current->data == value;
+        previous->lock.unlockPool();
+        return found;
+    }
+
+    // Unlinks every node while holding the sentinel, so no new thread can enter. Each node is locked once on
+    // the way out to wait for threads already past the sentinel to move on.
+    void clear() {
+        head.lock.lockPool();
+
+        Block* first = nullptr;
+        Block* last = nullptr;
+        size_t count = 0;
+
+        while (ConcurrentNode* current = head.next.load(std::memory_order_relaxed)) {
+            current->lock.lockPool();
+            unlinkAfter(&head, current);
+            current->lock.unlockPool();
+
+            if (reclaimer != nullptr) {
+                reclaimer->retire(reinterpret_cast<Block*>(current));
+                count++;
+                continue;
+            }
+            current->~ConcurrentNode();
+
+            Block* block = reinterpret_cast<Block*>(current);
+            block->next = nullptr;
+
+            if (last == nullptr) {
+                first = block;
+            }
+            else {
+                last->next = block;
+            }
+            last = block;
+            count++;
+        }
+        head.lock.unlockPool();
+
+        length.fetch_sub(count, std::memory_order_relaxed);
+
+        if (first != nullptr) {
+            pool->deallocateChain(first, last, count);
+        }
+    }
+
+    void display() {
+        ConcurrentNode* previous = &head;
+        previous->lock.lockPool();
+
+        while (ConcurrentNode* current = previous->next.load(std::memory_order_relaxed)) {
+            current->lock.lockPool();
+            previous->lock.unlockPool();
+            std::cout << current->data << " ";
+            previous = current;
+        }
+        previous->lock.unlockPool();
+        std::cout << std::endl;
+    }
+
+    ~ConcurrentLinkedList() {
+        clear();
+    }
+private:
+    // Walks hand-over-hand and returns, still locked, the last node whose successor is null or not less than
+    // value. The successor needs no lock to read: it cannot be unlinked while its predecessor is held.
+    ConcurrentNode* lockBefore(int value) {
+        ConcurrentNode* previous = &head;
+        previous->lock.lockPool();
+
+        for (ConcurrentNode* current = previous->next.load(std::memory_order_relaxed); current != nullptr && current->data < value;
+             current = current->next.load(std::memory_order_relaxed)) {
+            current->lock.lockPool();
+            previous->lock.unlockPool();
+            previous = current;
+        }
+        return previous;
+    }
+
+    // Both nodes are locked. The removed node keeps its next link so a lock-free reader on it can carry on.
+    static void unlinkAfter(ConcurrentNode* previous, ConcurrentNode* node) {
+        node->removed.store(true, std::memory_order_release);
+        previous->next.store(node->next.load(std::memory_order_relaxed), std::memory_order_release);
+    }
+
+    void releaseNode(ConcurrentNode* node) {
+        if (reclaimer != nullptr) {
+            reclaimer->retire(reinterpret_cast<Block*>(node));
+            return;
+        }
+        node->~ConcurrentNode();
+        pool->deallocateBlock(reinterpret_cast<Block*>(node));
+    }
+};
+
+// Vectorized scans over a chain of UnrolledNodes. simdKernels() picks the widest instruction set the CPU supports
+// the first time it is called: AVX-512F, AVX2 or SSE4.1 on x86, NEON on ARM64, and plain loops elsewhere. Each
+// kernel walks the whole chain itself, so a scan costs one indirect call, and keeps its vector accumulators
+// across nodes, reducing them once at the end. A full node is a whole number of vectors in every tier; AVX2 and
+// AVX-512 finish a partial one with masked loads, SSE4.1 and NEON with the scalar loop.
+enum class SimdCompare {
+    Equal,
+    Less,
+    Greater
+};
+
+enum class IntPredicate {
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual
+};
+
+struct SimdKernels {
+    const char* name;
+    // Node holding the first match, with the value's index and the node before it; nullptr if there is none
+    UnrolledNode* (*find)(UnrolledNode* node, int value, UnrolledNode*& previous, size_t& index);
+    size_t (*count)(const UnrolledNode* node, SimdCompare compare, int operand); // Values v with v <compare> operand
+    int64_t (*sum)(const UnrolledNode* node);
+    int (*min)(const UnrolledNode* node); // INT_MAX for an empty chain
+    int (*max)(const UnrolledNode* node); // INT_MIN for an empty chain
+};
+
+unsigned lowestBit(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+// Run-level loops: the scalar tier's inner loops and the other tiers' tails.
+size_t findScalar(const int* values, size_t n, int value) {
+    for (size_t i = 0; i < n; i++) {
+        if (values[i] == value) {
+            return i;
+        }
+    }
+    return n;
+}
+
+size_t countScalar(const int* values, size_t n, SimdCompare compare, int operand) {
+    size_t count = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        count += compare == SimdCompare::Equal ? values[i] == operand
+            : compare == SimdCompare::Less ? values[i] < operand : values[i] > operand;
+    }
+    return count;
+}
+
+int64_t sumScalar(const int* values, size_t n) {
+    int64_t sum = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+int minScalar(const int* values, size_t n) {
+    int result = std::numeric_limits<int>::max();
+
+    for (size_t i = 0; i < n; i++) {
+        result = values[i] < result ? values[i] : result;
+    }
+    return result;
+}
+
+int maxScalar(const int* values, size_t n) {
+    int result = std::numeric_limits<int>::min();
+
+    for (size_t i = 0; i < n; i++) {
+        result = values[i] > result ? values[i] : result;
+    }
+    return result;
+}
+
+UnrolledNode* findListScalar(UnrolledNode* node, int value, UnrolledNode*& previous, size_t& index) {
+    for (previous = nullptr; node != nullptr; previous = node, node = node->next) {
+        index = findScalar(node->values, node->count, value);
+
+        if (index != static_cast<size_t>(node->count)) {
+            return node;
+        }
+    }
+    return nullptr;
+}
+
+size_t countListScalar(const UnrolledNode* node, SimdCompare compare, int operand) {
+    size_t count = 0;
+
+    for (; node != nullptr; node = node->next) {
+        count += countScalar(node->values, node->count, compare, operand);
+    }
+    return count;
+}
+
+int64_t sumListScalar(const UnrolledNode* node) {
+    int64_t sum = 0;
+
+    for (; node != nullptr; node = node->next) {
+        sum += sumScalar(node->values, node->count);
+    }
+    return sum;
+}
+
+int minListScalar(const UnrolledNode* node) {
+    int result = std::numeric_limits<int>::max();
+
+    for (; node != nullptr; node = node->next) {
+        result = std::min(result, minScalar(node->values, node->count));
+    }
+    return result;
+}
+
+int maxListScalar(const UnrolledNode* node) {
+    int result = std::numeric_limits<int>::min();
+
+    for (; node != nullptr; node = node->next) {
+        result = std::max(result, maxScalar(node->values, node->count));
+    }
+    return result;
+}
+
+#ifdef MEMORY_POOL_SIMD_X86
+SIMD_TARGET("sse4.1") inline __m128i compareSse(__m128i values, __m128i operand, SimdCompare compare) {
+    switch (compare) {
+    case SimdCompare::Equal:
+        return _mm_cmpeq_epi32(values, operand);
+    case SimdCompare::Less:
+        return _mm_cmplt_epi32(values, operand);
+    default:
+        return _mm_cmpgt_epi32(values, operand);
+    }
+}
+
+SIMD_TARGET("sse4.1") UnrolledNode* findListSse(UnrolledNode* node, int value, UnrolledNode*& previous,
+        size_t& index) {
+    __m128i needle = _mm_set1_epi32(value);
+
+    for (previous = nullptr; node != nullptr; previous = node, node = node->next) {
+        size_t n = node->count;
+        size_t i = 0;
+
+        for (; i + 4 <= n; i += 4) {
+            __m128i hits = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(node->values + i)), needle);
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(hits));
+
+            if (mask != 0) {
+                index = i + lowestBit(static_cast<unsigned>(mask));
+                return node;
+            }
+        }
+
+        index = i + findScalar(node->values + i, n - i, value);
+
+        if (index != n) {
+            return node;
+        }
+    }
+    return nullptr;
+}
+
+SIMD_TARGET("sse4.1") size_t countListSse(const UnrolledNode* node, SimdCompare compare, int operand) {
+    __m128i target = _mm_set1_epi32(operand);
+    __m128i counts = _mm_setzero_si128();
+    size_t count = 0;
+
+    for (; node != nullptr; node = node->next) {
+        size_t n = node->count;
+        size_t i = 0;
+
+        for (; i + 4 <= n; i += 4) { // A matching lane compares to -1, so subtracting counts it
+            counts = _mm_sub_epi32(counts, compareSse(_mm_loadu_si128(reinterpret_cast<const __m128i*>(node->values + i)),
+                target, compare));
+        }
+        count += countScalar(node->values + i, n - i, compare, operand);
+    }
+
+    uint32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), counts);
+    return count + lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+SIMD_TARGET("sse4.1") int64_t sumListSse(const UnrolledNode* node) {
+    __m128i sums = _mm_setzero_si128();
+    int64_t sum = 0;
+
+    for (; node != nullptr; node = node->next) {
+        size_t n = node->count;
+        size_t i = 0;
+
+        for (; i + 4 <= n; i += 4) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(node->values + i));
+            sums = _mm_add_epi64(sums, _mm_cvtepi32_epi64(chunk));
+            sums = _mm_add_epi64(sums, _mm_cvtepi32_epi64(_mm_srli_si128(chunk, 8)));
+        }
+        sum += sumScalar(node->values + i, n - i);
+    }
+
+    int64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sums);
+    return sum + lanes[0] + lanes[1];
+}
+
+SIMD_TARGET("sse4.1") int minListSse(const UnrolledNode* node) {
+    __m128i result = _mm_set1_epi32(std::numeric_limits<int>::max());
+    int tail = std::numeric_limits<int>::max();
+
+    for (; node != nullptr; node = node->next) {
+        size_t n = node->count;
+        size_t i = 0;
+
+        for (; i + 4 <= n; i += 4) {
+            result = _mm_min_epi32(result, _mm_loadu_si128(reinterpret_cast<const __m128i*>(node->values + i)));
+        }
+        tail = std::min(tail, minScalar(node->values + i, n - i));
+    }
+
+    int lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), result);
+    return std::min({lanes[0], lanes[1], lanes[2], lanes[3], tail});
+}
+
+SIMD_TARGET("sse4.1") int maxListSse(const UnrolledNode* node) {
+    __m128i result = _mm_set1_epi32(std::numeric_limits<int>::min());
+    int tail = std::numeric_limits<int>::min();
+
+    for (; node != nullptr; node = node->next) {
+        size_t n = node->count;
+        size_t i = 0;
+
+        for (; i + 4 <= n; i += 4) {
+            result = _mm_max_epi32(result, _mm_loadu_si128(reinterpret_cast<const __m128i*>(node->values + i)));
+        }
+        tail = std::max(tail, maxScalar(node->values + i, n - i));
+    }
+
+    int lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), result);
+    return std::max({lanes[0], lanes[1], lanes[2], lanes[3], tail});
+}
+
+SIMD_TARGET("avx2") inline __m256i compareAvx2(__m256i values, __m256i operand, SimdCompare compare) {
+    switch (compare) {
+    case SimdCompare::Equal:
+        return _mm256_cmpeq_epi32(values, operand);
+    case SimdCompare::Less:
+        return _mm256_cmpgt_epi32(operand, values);
+    default:
+        return _mm256_cmpgt_epi32(values, operand);
+    }
+}
+
+// All-ones in the first `remaining` (1 to 7) lanes, for the masked load that finishes a partial node.
+SIMD_TARGET("avx2") inline __m256i tailMaskAvx2(size_t remaining) {
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(remaining)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+SIMD_TARGET("avx2") UnrolledNode* findListAvx2(UnrolledNode* node, int value, UnrolledNode*& previous,
+        size_t& index) {
+    __m256i needle = _mm256_set1_epi32(value);
+
+    for (previous = nullptr; node != nullptr; previous = node, node = node->next) {
+        size_t n = node->count;
+
+        for (size_t i = 0; i < n; i += 8) {
+            bool full = i + 8 <= n;
+            __m256i lanes = full ? _mm256_set1_epi32(-1) : tailMaskAvx2(n - i);
+            __m256i chunk = full ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(node->values + i))
+                : _mm256_maskload_epi32(node->values + i, lanes);
+            int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(_mm256_cmpeq_epi32(chunk, needle), lanes)));
+
+            if (mask != 0) {
+                index = i + lowestBit(static_cast<unsigned>(mask));
+                return node;
+            }
+        }
+    }
+    return nullptr;
+}
+
+SIMD_TARGET("avx2") size_t countListAvx2(const UnrolledNode* node, SimdCompare compare, int operand) {
+    __m256i target = _mm256_set1_epi32(operand);
+    __m256i counts = _mm256_setzero_si256();
+
+    for (; node != nullptr; node = node->next) {
+        size_t n = node->count;
+        size_t i = 0;
+
+        for (; i + 8 <= n; i += 8) { // A matching lane compares to -1, so subtracting counts it
+            counts = _mm256_sub_epi32(counts, compareAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(node->values + i)),
+                target, compare));
+        }
+
+        if (i < n) {
+            __m256i lanes = tailMaskAvx2(n - i);
+            __m256i hits = compareAvx2(_mm256_maskload_epi32(node->values + i, lanes), target, compare);
+            counts = _mm256_sub_epi32(counts, _mm256_and_si256(hits, lanes));
+        }
+    }
+
+    uint32_t lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), counts);
+    size_t count = 0;
+
+    for (uint32_t lane : lanes) {
+        count += lane;
+    }
+    return count;
+}
+
+SIMD_TARGET("avx2") int64_t sumListAvx2(const UnrolledNode* node) {
+    __m256i sums = _mm256_setzero_si256();
+
+    for (; node != nullptr; node = node->next) {
+        size_t n = node->count;
+
+        for (size_t i = 0; i < n; i += 8) { // Masked-off lanes load as zero
+            __m256i chunk = i + 8 <= n ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(node->values + i))
+                : _mm256_maskload_epi32(node->values + i, tailMaskAvx2(n - i));
+            sums = _mm256_add_epi64(sums, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(chunk)));
+            sums = _mm256_add_epi64(sums, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(chunk, 1)));
+        }
+    }
+
+    int64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sums);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+SIMD_TARGET("avx2") int minListAvx2(const UnrolledNode* node) {
+    __m256i result = _mm256_set1_epi32(std::numeric_limits<int>::max());
+
+    for (; node != nullptr; node = node->next) {
+        size_t n = node->count;
+        size_t i = 0;
+
+        for (; i + 8 <= n; i += 8) {
+            result = _mm256_min_epi32(result, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(node->values + i)));
+        }
+
+        if (i < n) { // Masked-off lanes keep the running minimum
+            __m256i lanes = tailMaskAvx2(n - i);
+            __m256i chunk = _mm256_blendv_epi8(result, _mm256_maskload_epi32(node->values + i, lanes), lanes);
+            result = _mm256_min_epi32(result, chunk);
+        }
+    }
+
+    int lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), result);
+    return *std::min_element(lanes, lanes + 8);
+}
+
+SIMD_TARGET("avx2") int maxListAvx2(const UnrolledNode* node) {
+    __m256i result = _mm256_set1_epi32(std::numeric_limits<int>::min());
+
+    for (; node != nullptr; node = node->next) {
+        size_t n = node->count;
+        size_t i = 0;
+
+        for (; i + 8 <= n; i += 8) {
+            result = _mm256_max_epi32(result, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(node->values + i)));
+        }
+
+        if (i < n) {
+            __m256i lanes = tailMaskAvx2(n - i);
+            __m256i chunk = _mm256_blendv_epi8(result, _mm256_maskload_epi32(node->values + i, lanes), lanes);
+            result = _mm256_max_epi32(result, chunk);
+        }
+    }
+
+    int lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), result);
+    return *std::max_element(lanes, lanes + 8);
+}
+
+// GCC 12's AVX-512 headers seed their _mm512_undefined_* placeholders from themselves, which trips
+// -Wuninitialized once the intrinsics are inlined into a target("avx512f") function.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+SIMD_TARGET("avx512f") inline __mmask16 compareAvx512(__m512i values, __m512i operand, SimdCompare compare) {
+    switch (compare) {
+    case SimdCompare::Equal:
+        return _mm512_cmpeq_epi32_mask(values, operand);
+    case SimdCompare::Less:
+        return _mm512_cmplt_epi32_mask(values, operand);
+    default:
+        return _mm512_cmpgt_epi32_mask(values, operand);
+    }
+}
+
+// The lanes of the vector at offset i that are still inside a run of n values. Masked lanes are free in
+// AVX-512, so every vector goes through the same masked path.
+inline __mmask16 laneMaskAvx512(size_t i, size_t n) {
+    return static_cast<__mmask16>(i + 16 <= n ? 0xFFFF : (1u << (n - i)) - 1);
+}
+
+SIMD_TARGET("avx512f") UnrolledNode* findListAvx512(UnrolledNode* node, int value,
+        UnrolledNode*& previous, size_t& index) {
+    __m512i needle = _mm512_set1_epi32(value);
+
+    for (previous = nullptr; node != nullptr; previous = node, node = node->next) {
+        size_t n = node->count;
+
+        for (size_t i = 0; i < n; i += 16) {
+            __mmask16 lanes = laneMaskAvx512(i, n);
+            __mmask16 mask = _mm512_mask_cmpeq_epi32_mask(lanes, _mm512_maskz_loadu_epi32(lanes, node->values + i), needle);
+
+            if (mask != 0) {
+                index = i + lowestBit(mask);
+                return node;
+            }
+        }
+    }
+    return nullptr;
+}
+
+SIMD_TARGET("avx512f") size_t countListAvx512(const UnrolledNode* node, SimdCompare compare, int operand) {
+    __m512i target = _mm512_set1_epi32(operand);
+    __m512i counts = _mm512_setzero_si512();
+    __m512i ones = _mm512_set1_epi32(1);
+
+    for (; node != nullptr; node = node->next) {
+        size_t n = node->count;
+
+        for (size_t i = 0; i < n; i += 16) {
+            __mmask16 lanes = laneMaskAvx512(i, n);
+            __mmask16 hits = lanes & compareAvx512(_mm512_maskz_loadu_epi32(lanes, node->values + i), target, compare);
+            counts = _mm512_mask_add_epi32(counts, hits, counts, ones);
+        }
+    }
+    // Lanes are widened before the reduction so the total doesn't wrap at 2^32, matching the other tiers
+    __m512i wide = _mm512_add_epi64(_mm512_cvtepu32_epi64(_mm512_castsi512_si256(counts)),
+        _mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(counts, 1)));
+    return static_cast<size_t>(_mm512_reduce_add_epi64(wide));
+}
+
+SIMD_TARGET("avx512f") int64_t sumListAvx512(const UnrolledNode* node) {
+    __m512i sums = _mm512_setzero_si512();
+
+    for (; node != nullptr; node = node->next) {
+        size_t n = node->count;
+
+        for (size_t i = 0; i < n; i += 16) { // Masked-off lanes load as zero
+            __m512i chunk = _mm512_maskz_loadu_epi32(laneMaskAvx512(i, n), node->values + i);
+            sums = _mm512_add_epi64(sums, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(chunk)));
+            sums = _mm512_add_epi64(sums, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(chunk, 1)));
+        }
+    }
+    return _mm512_reduce_add_epi64(sums);
+}
+
+SIMD_TARGET("avx512f") int minListAvx512(const UnrolledNode* node) {
+    __m512i result = _mm512_set1_epi32(std::numeric_limits<int>::max());
+
+    for (; node != nullptr; node = node->next) {
+        size_t n = node->count;
+
+        for (size_t i = 0; i < n; i += 16) { // Masked-off lanes keep the running minimum
+            __mmask16 lanes = laneMaskAvx512(i, n);
+            result = _mm512_mask_min_epi32(result, lanes, result, _mm512_maskz_loadu_epi32(lanes, node->values + i));
+        }
+    }
+    return _mm512_reduce_min_epi32(result);
+}
+
+SIMD_TARGET("avx512f") int maxListAvx512(const UnrolledNode* node) {
+    __m512i result = _mm512_set1_epi32(std::numeric_limits<int>::min());
+
+    for (; node != nullptr; node = node->next) {
+        size_t n = node->count;
+
+        for (size_t i = 0; i < n; i += 16) {
+            __mmask16 lanes = laneMaskAvx512(i, n);
+            result = _mm512_mask_max_epi32(result, lanes, result, _mm512_maskz_loadu_epi32(lanes, node->values + i));
+        }
+    }
+    return _mm512_reduce_max_epi32(result);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+#ifdef MEMORY_POOL_SIMD_NEON
+inline uint32x4_t compareNeon(int32x4_t values, int32x4_t operand, SimdCompare compare) {
+    switch (compare) {
+    case SimdCompare::Equal:
+        return vceqq_s32(values, operand);
+    case SimdCompare::Less:
+        return vcltq_s32(values, operand);
+    default:
+        return vcgtq_s32(values, operand);
+    }
+}
+
+UnrolledNode* findListNeon(UnrolledNode* node, int value, UnrolledNode*& previous, size_t& index) {
+    int32x4_t needle = vdupq_n_s32(value);
+
+    for (previous = nullptr; node != nullptr; previous = node, node = node->next) {
+        size_t n = node->count;
+        size_t i = 0;
+
+        for (; i + 4 <= n; i += 4) {
+            if (vmaxvq_u32(vceqq_s32(vld1q_s32(node->values + i), needle)) != 0) {
+                index = i + findScalar(node->values + i, 4, value);
+                return node;
+            }
+        }
+
+        index = i + findScalar(node->values + i, n - i, value);
+
+        if (index != n) {
+            return node;
+        }
+    }
+    return nullptr;
+}
+
+size_t countListNeon(const UnrolledNode* node, SimdCompare compare, int operand) {
+    int32x4_t target = vdupq_n_s32(operand);
+    uint32x4_t counts = vdupq_n_u32(0);
+    size_t count = 0;
+
+    for (; node != nullptr; node = node->next) {
+        size_t n = node->count;
+        size_t i = 0;
+
+        for (; i + 4 <= n; i += 4) {
+            counts = vsubq_u32(counts, compareNeon(vld1q_s32(node->values + i), target, compare));
+        }
+        count += countScalar(node->values + i, n - i, compare, operand);
+    }
+    return count + vaddvq_u32(counts);
+}
+
+int64_t sumListNeon(const UnrolledNode* node) {
+    int64x2_t sums = vdupq_n_s64(0);
+    int64_t sum = 0;
+
+    for (; node != nullptr; node = node->next) {
+        size_t n = node->count;
+        size_t i = 0;
+
+        for (; i + 4 <= n; i += 4) {
+            sums = vpadalq_s32(sums, vld1q_s32(node->values + i));
+        }
+        sum += sumScalar(node->values + i, n - i);
+    }
+    return sum + vaddvq_s64(sums);
+}
+
+int minListNeon(const UnrolledNode* node) {
+    int32x4_t result = vdupq_n_s32(std::numeric_limits<int>::max());
+    int tail = std::numeric_limits<int>::max();
+
+    for (; node != nullptr; node = node->next) {
+        size_t n = node->count;
+        size_t i = 0;
+
+        for (; i + 4 <= n; i += 4) {
+            result = vminq_s32(result, vld1q_s32(node->values + i));
+        }
+        tail = std::min(tail, minScalar(node->values + i, n - i));
+    }
+    return std::min(vminvq_s32(result), tail);
+}
+
+int maxListNeon(const UnrolledNode* node) {
+    int32x4_t result = vdupq_n_s32(std::numeric_limits<int>::min());
+    int tail = std::numeric_limits<int>::min();
+
+    for (; node != nullptr; node = node->next) {
+        size_t n = node->count;
+        size_t i = 0;
+
+        for (; i + 4 <= n; i += 4) {
+            result = vmaxq_s32(result, vld1q_s32(node->values + i));
+        }
+        tail = std::max(tail, maxScalar(node->values + i, n - i));
+    }
+    return std::max(vmaxvq_s32(result), tail);
+}
+#endif
+
+SimdKernels selectSimdKernels() {
+#ifdef MEMORY_POOL_SIMD_X86
+#ifdef _MSC_VER
+    // AVX state has to be enabled by the OS (XCR0) as well as supported by the CPU.
+    int info[4];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    unsigned long long xcr0 = (info[2] & (1 << 27)) != 0 ? _xgetbv(0) : 0;
+    __cpuidex(info, 7, 0);
+    bool avx2 = (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+    bool avx512 = (xcr0 & 0xE6) == 0xE6 && (info[1] & (1 << 16)) != 0;
+#else
+    __builtin_cpu_init();
+    bool sse41 = __builtin_cpu_supports("sse4.1");
+    bool avx2 = __builtin_cpu_supports("avx2");
+    bool avx512 = __builtin_cpu_supports("avx512f");
+#endif
+
+    if (avx512) {
+        return SimdKernels{"avx512f", findListAvx512, countListAvx512, sumListAvx512, minListAvx512, maxListAvx512};
+    }
+    if (avx2) {
+        return SimdKernels{"avx2", findListAvx2, countListAvx2, sumListAvx2, minListAvx2, maxListAvx2};
+    }
+    if (sse41) {
+        return SimdKernels{"sse4.1", findListSse, countListSse, sumListSse, minListSse, maxListSse};
+    }
+#elif defined(MEMORY_POOL_SIMD_NEON)
+    return SimdKernels{"neon", findListNeon, countListNeon, sumListNeon, minListNeon, maxListNeon};
+#endif
+    return SimdKernels{"scalar", findListScalar, countListScalar, sumListScalar, minListScalar, maxListScalar};
+}
+
+const SimdKernels& simdKernels() {
+    static const SimdKernels kernels = selectSimdKernels();
+    return kernels;
+}
+
+// count_if over a chain of n values for the comparisons the kernels vectorize; the negated forms count the
+// complement.
+size_t countMatching(const SimdKernels& kernels, const UnrolledNode* node, size_t n, IntPredicate predicate, int operand) {
+    switch (predicate) {
+    case IntPredicate::Equal:
+        return kernels.count(node, SimdCompare::Equal, operand);
+    case IntPredicate::NotEqual:
+        return n - kernels.count(node, SimdCompare::Equal, operand);
+    case IntPredicate::Less:
+        return kernels.count(node, SimdCompare::Less, operand);
+    case IntPredicate::GreaterEqual:
+        return n - kernels.count(node, SimdCompare::Less, operand);
+    case IntPredicate::Greater:
+        return kernels.count(node, SimdCompare::Greater, operand);
+    default:
+        return n - kernels.count(node, SimdCompare::Greater, operand);
+    }
+}
+
+// Singly linked list of UnrolledNode blocks. Values keep insertion order across nodes; every node holds at least
+// one value, and removals merge a node that drops below half full with its successor when they fit together.
+class UnrolledLinkedList {
+private:
+    static constexpr int Capacity = UnrolledNode::Capacity;
+
+    UnrolledNode* head;
+    UnrolledNode* tail;
+    size_t length; // Cached value count
+    size_t nodeCount;
+    MemoryPool* pool;
+public:
+    UnrolledLinkedList(MemoryPool* memoryPool) : head(nullptr), tail(nullptr), length(0), nodeCount(0), pool(memoryPool) {
+        if (pool->getBlockSize() < sizeof(UnrolledNode) || pool->getAlignment() < alignof(UnrolledNode)) {
+            throw std::invalid_argument("Pool blocks are too small for UnrolledNode");
+        }
+    }
+
+    UnrolledLinkedList(const UnrolledLinkedList&) = delete;
+    UnrolledLinkedList& operator=(const UnrolledLinkedList&) = delete;
+
+    int getLength() {
+        return static_cast<int>(length);
+    }
+
+    size_t getNodeCount() const {
+        return nodeCount;
+    }
+
+    UnrolledNode* getHead() const {
+        return head;
+    }
+
+    // Appends to the tail node, taking a new block only when it is full. Returns false if the pool is out.
+    bool insert(int value) {
+        if (tail == nullptr || tail->count == Capacity) {
+            UnrolledNode* newNode = createNode();
+
+            if (!newNode) {
+                return false;
+            }
+
+            if (head == nullptr) {
+                head = newNode;
+            }
+            else {
+                tail->next = newNode;
+            }
+            tail = newNode;
+        }
+
+        tail->values[tail->count++] = value;
+        length++;
+        return true;
+    }
+
+    // Removes the first occurrence of value; returns false if there is none.
+    bool remove(int value) {
+        UnrolledNode* previous;
+        size_t index;
+        UnrolledNode* current = simdKernels().find(head, value, previous, index);
+
+        if (current == nullptr) {
+            return false;
+        }
+
+        int* found = current->values + index;
+
+        std::memmove(found, found + 1, (current->values + current->count - found - 1) * sizeof(int));
+        current->count--;
+        length--;
+
+        if (current->count == 0) {
+            unlinkNode(previous, current);
+        }
+        else if (current->count < Capacity / 2 && current->next != nullptr
+                 && current->count + current->next->count <= Capacity) {
+            UnrolledNode* next = current->next;
+            std::memcpy(current->values + current->count, next->values, next->count * sizeof(int));
+            current->count += next->count;
+            unlinkNode(current, next);
+        }
+        return true;
+    }
+
+    // Whole-list scans; each is a single call into the SIMD kernels, which walk the nodes themselves.
+    size_t count(IntPredicate predicate, int operand) const {
+        return countMatching(simdKernels(), head, length, predicate, operand);
+    }
+
+    int64_t sum() const {
+        return simdKernels().sum(head);
+    }
+
+    // INT_MAX for an empty list.
+    int min() const {
+        return simdKernels().min(head);
+    }
+
+    // INT_MIN for an empty list.
+    int max() const {
+        return simdKernels().max(head);
+    }
+
+    // Sorts every node's run in place, then merges runs bottom-up through a binary counter of bins, as
+    // std::list::sort does. Merges write into packed nodes recycled from consumed input, so the result is also
+    // densely packed. Two spare blocks cover the output running ahead of the input; without them the list is
+    // left unchanged and sort returns false.
+    bool sort() {
+        if (head == nullptr) {
+            return true;
+        }
+
+        UnrolledNode* spares = nullptr;
+
+        for (int i = 0; i < 2; i++) {
+            UnrolledNode* spare = createNode();
+
+            if (!spare) {
+                releaseChain(spares);
+                return false;
+            }
+            spare->next = spares;
+            spares = spare;
+        }
+
+        UnrolledNode* bins[64] = {};
+        int usedBins = 0;
+
+        while (head != nullptr) {
+            UnrolledNode* run = head;
+            head = head->next;
+            run->next = nullptr;
+            std::sort(run->values, run->values + run->count);
+
+            int bin = 0;
+
+            for (; bin < usedBins && bins[bin] != nullptr; bin++) {
+                run = mergeRuns(bins[bin], run, spares);
+                bins[bin] = nullptr;
+            }
+            bins[bin] = run;
+
+            if (bin == usedBins) {
+                usedBins++;
+            }
+        }
+
+        UnrolledNode* sorted = nullptr;
+
+        for (int bin = 0; bin < usedBins; bin++) {
+            if (bins[bin] != nullptr) {
+                sorted = sorted == nullptr ? bins[bin] : mergeRuns(bins[bin], sorted, spares);
+            }
+        }
+
+        releaseChain(spares);
+        head = sorted;
+        nodeCount = 0;
+
+        for (UnrolledNode* current = head; current != nullptr; current = current->next) {
+            tail = current;
+            nodeCount++;
+        }
+        return true;
+    }
+
+    void clear() {
+        releaseChain(head);
+        head = nullptr;
+        tail = nullptr;
+        length = 0;
+        nodeCount = 0;
+    }
+
+    void display() const {
+        for (UnrolledNode* current = head; current != nullptr; current = current->next) {
+            for (int i = 0; i < current->count; i++) {
+                std::cout << current->values[i] << " ";
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    ~UnrolledLinkedList() {
+        releaseChain(head);
+    }
+private:
+    UnrolledNode* createNode() {
+        Block* block = pool->allocateBlock();
+
+        if (!block) {
+            return nullptr; // Pool is full
+        }
+
+        nodeCount++;
+        return new (block) UnrolledNode();
+    }
+
+    void unlinkNode(UnrolledNode* previous, UnrolledNode* node) {
+        if (previous == nullptr) {
+            head = node->next;
+        }
+        else {
+            previous->next = node->next;
+        }
+
+        if (node == tail) {
+            tail = previous;
+        }
+        nodeCount--;
+
+        pool->deallocateBlock(reinterpret_cast<Block*>(node));
+    }
+
+    // Merges two sorted runs into packed nodes. Output nodes come from spares and every fully consumed input
+    // node goes back onto it; stable, taking from left on ties.
+    static UnrolledNode* mergeRuns(UnrolledNode* left, UnrolledNode* right, UnrolledNode*& spares) {
+        UnrolledNode* first = nullptr;
+        UnrolledNode* out = nullptr;
+        int leftIndex = 0;
+        int rightIndex = 0;
+
+        while (left != nullptr || right != nullptr) {
+            bool takeLeft = right == nullptr || (left != nullptr && left->values[leftIndex] <= right->values[rightIndex]);
+            int value = takeLeft ? left->values[leftIndex++] : right->values[rightIndex++];
+
+            if (out == nullptr || out->count == Capacity) {
+                UnrolledNode* node = spares;
+                spares = spares->next;
+                node->next = nullptr;
+                node->count = 0;
+
+                if (out == nullptr) {
+                    first = node;
+                }
+                else {
+                    out->next = node;
+                }
+                out = node;
+            }
+            out->values[out->count++] = value;
+
+            if (takeLeft && leftIndex == left->count) {
+                recycle(left, spares);
+                leftIndex = 0;
+            }
+            else if (!takeLeft && rightIndex == right->count) {
+                recycle(right, spares);
+                rightIndex = 0;
+            }
+        }
+        return first;
+    }
+
+    // Advances run past its consumed head node and pushes that node onto spares.
+    static void recycle(UnrolledNode*& run, UnrolledNode*& spares) {
+        UnrolledNode* used = run;
+        run = run->next;
+        used->next = spares;
+        spares = used;
+    }
+
+    // Returns a nullptr-terminated chain of nodes to the pool in one splice.
+    void releaseChain(UnrolledNode* first) {
+        if (first == nullptr) {
+            return;
+        }
+
+        Block* last = nullptr;
+        size_t count = 0;
+
+        for (UnrolledNode* current = first; current != nullptr;) {
+            Block* block = reinterpret_cast<Block*>(current);
+            current = current->next; // read next before the Block view overwrites the node
+
+            if (last != nullptr) {
+                last->next = block;
+            }
+            last = block;
+            count++;
+        }
+        nodeCount -= count;
+        pool->deallocateChain(reinterpret_cast<Block*>(first), last, count);
+    }
+};
+
+// Benchmarks, run with `--benchmark [maxListElements]`. Every case uses fixed seeds and sizes, runs once to
+// warm up and reports the median of BenchmarkRepetitions timed runs, so numbers are comparable across machines.
+constexpr int BenchmarkRepetitions = 5;
+constexpr size_t BenchmarkBatch = 1000; // Blocks held live at once in the alloc/free cases
+constexpr size_t BenchmarkRounds = 2000;
+
+volatile uintptr_t benchmarkSink; // Keeps results observable so the optimizer can't drop the work
+
+template<typename Body>
+double medianSeconds(Body&& body) {
+    std::vector<double> samples;
+    body();
+
+    for (int i = 0; i < BenchmarkRepetitions; i++) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        samples.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+void reportBenchmark(const std::string& name, double seconds, size_t operations) {
+    std::cout << std::left << std::setw(52) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(12) << seconds * 1e9 / operations << " ns/op"
+              << std::setw(12) << operations / seconds / 1e6 << " Mops/s" << std::endl;
+}
+
+// Holds BenchmarkBatch blocks live, frees them, and repeats; one operation is one allocate plus one free.
+template<typename Allocate, typename Deallocate>
+void allocFreeRounds(size_t rounds, Allocate&& allocate, Deallocate&& deallocate) {
+    void* live[BenchmarkBatch];
+
+    for (size_t round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < BenchmarkBatch; i++) {
+            live[i] = allocate();
+        }
+        benchmarkSink = reinterpret_cast<uintptr_t>(live[round % BenchmarkBatch]);
+
+        for (size_t i = 0; i < BenchmarkBatch; i++) {
+            deallocate(live[i]);
+        }
+    }
+}
+
+void benchmarkAllocFree() {
+    const size_t operations = BenchmarkRounds * BenchmarkBatch;
+
+    for (FreeListStrategy strategy : {FreeListStrategy::Locked, FreeListStrategy::LockFree}) {
+        MemoryPool pool(sizeof(Node), BenchmarkBatch, alignof(std::max_align_t), strategy);
+
+        double seconds = medianSeconds([&] {
+            allocFreeRounds(BenchmarkRounds, [&] { return static_cast<void*>(pool.allocateBlock()); },
+                [&](void* p) { pool.deallocateBlock(static_cast<Block*>(p)); });
+        });
+        reportBenchmark(strategy == FreeListStrategy::Locked ? "alloc/free MemoryPool (locked)" : "alloc/free MemoryPool (lock-free)",
+            seconds, operations);
+    }
+
+    double seconds = medianSeconds([&] {
+        allocFreeRounds(BenchmarkRounds, [] { return operator new(sizeof(Node)); }, [](void* p) { operator delete(p); });
+    });
+    reportBenchmark("alloc/free operator new", seconds, operations);
+
+    std::pmr::unsynchronized_pool_resource resource;
+
+    seconds = medianSeconds([&] {
+        allocFreeRounds(BenchmarkRounds, [&] { return resource.allocate(sizeof(Node), alignof(Node)); },
+            [&](void* p) { resource.deallocate(p, sizeof(Node), alignof(Node)); });
+    });
+    reportBenchmark("alloc/free pmr::unsynchronized_pool_resource", seconds, operations);
+}
+
+// Every thread runs the same alloc/free rounds against one shared allocator; reports aggregate throughput.
+template<typename Allocate, typename Deallocate>
+double contendedSeconds(size_t threads, size_t rounds, Allocate&& allocate, Deallocate&& deallocate) {
+    return medianSeconds([&] {
+        std::vector<std::thread> workers;
+
+        for (size_t t = 0; t < threads; t++) {
+            workers.emplace_back([&] { allocFreeRounds(rounds, allocate, deallocate); });
+        }
+
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    });
+}
+
+// 1, 2, 4, ... up to the hardware thread count, which is always included.
+std::vector<size_t> defaultThreadCounts() {
+    size_t maxThreads = std::thread::hardware_concurrency();
+
+    if (maxThreads == 0) {
+        maxThreads = 4;
+    }
+
+    std::vector<size_t> threadCounts;
+
+    for (size_t threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+    return threadCounts;
+}
+
+void benchmarkContention() {
+    const size_t rounds = BenchmarkRounds / 4;
+
+    for (size_t threads : defaultThreadCounts()) {
+        const size_t operations = threads * rounds * BenchmarkBatch;
+
+        for (FreeListStrategy strategy : {FreeListStrategy::Locked, FreeListStrategy::LockFree}) {
+            MemoryPool pool(sizeof(Node), threads * BenchmarkBatch, alignof(std::max_align_t), strategy);
+
+            double seconds = contendedSeconds(threads, rounds, [&] { return static_cast<void*>(pool.allocateBlock()); },
+                [&](void* p) { pool.deallocateBlock(static_cast<Block*>(p)); });
+            reportBenchmark(std::string(strategy == FreeListStrategy::Locked ? "MemoryPool (locked)" : "MemoryPool (lock-free)")
+                + " threads=" + std::to_string(threads), seconds, operations);
+        }
+
+        double seconds = contendedSeconds(threads, rounds, [] { return operator new(sizeof(Node)); },
+            [](void* p) { operator delete(p); });
+        reportBenchmark("operator new threads=" + std::to_string(threads), seconds, operations);
+    }
+}
+
+// One thread allocates and hands each block through a ring of slots to a second thread, which frees it: the
+// pipeline pattern, run with and without PoolOptions::remoteFree.
+void benchmarkCrossThreadFree() {
+    const size_t operations = BenchmarkRounds * BenchmarkBatch / 4;
+    static constexpr size_t RingSize = 256;
+
+    for (bool remoteFree : {false, true}) {
+        PoolOptions options;
+        options.remoteFree = remoteFree;
+        MemoryPool pool(sizeof(Node), 2 * RingSize, alignof(std::max_align_t), options);
+
+        double seconds = medianSeconds([&] {
+            std::atomic<Block*> ring[RingSize];
+
+            for (std::atomic<Block*>& entry : ring) {
+                entry.store(nullptr, std::memory_order_relaxed);
+            }
+
+            std::thread consumer([&] {
+                for (size_t freed = 0, i = 0; freed < operations; i = (i + 1) % RingSize) {
+                    Block* block = ring[i].exchange(nullptr, std::memory_order_acquire);
+
+                    if (block != nullptr) {
+                        pool.deallocateBlock(block);
+                        freed++;
+                    }
+                    else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+
+            for (size_t made = 0, i = 0; made < operations; i = (i + 1) % RingSize) {
+                if (ring[i].load(std::memory_order_relaxed) == nullptr) {
+                    ring[i].store(pool.allocateBlock(), std::memory_order_release);
+                    made++;
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            }
+            consumer.join();
+        });
+        reportBenchmark(remoteFree ? "cross-thread free, remote queues" : "cross-thread free, magazines", seconds, operations);
+    }
+}
+
+// Allocating far past the initial capacity forces repeated resizes; the pre-sized run isolates their cost.
+void benchmarkResize() {
+    const size_t blocks = 1 << 20;
+    std::vector<Block*> live(blocks);
+
+    for (size_t initial : {size_t(1024), blocks}) {
+        double seconds = medianSeconds([&] {
+            MemoryPool pool(sizeof(Node), initial);
+
+            for (size_t i = 0; i < blocks; i++) {
+                live[i] = pool.allocateBlock();
+            }
+            benchmarkSink = reinterpret_cast<uintptr_t>(live[blocks - 1]);
+        });
+        reportBenchmark(initial == blocks ? "allocate 1M blocks, pre-sized pool" : "allocate 1M blocks, growing from 1024",
+            seconds, blocks);
+    }
+}
+
+void benchmarkList(size_t maxElements) {
+    for (size_t elements = 1000; elements <= maxElements; elements *= 10) {
+        std::vector<int> values(elements);
+        std::mt19937 rng(42);
+
+        for (int& value : values) {
+            value = static_cast<int>(rng());
+        }
+
+        MemoryPool pool(sizeof(Node), elements);
+        std::string suffix = " n=" + std::to_string(elements);
+
+        double seconds = medianSeconds([&] {
+            SingleLinkedList list(&pool);
+
+            for (int value : values) {
+                list.insert(value);
+            }
+        });
+        reportBenchmark("SingleLinkedList insert" + suffix, seconds, elements);
+
+        SingleLinkedList list(&pool);
+        list.insert(values.data(), values.size());
+
+        seconds = medianSeconds([&] {
+            list.clear();
+            list.insert(values.data(), values.size());
+            list.mergeSort();
+        });
+        reportBenchmark("SingleLinkedList rebuild + mergeSort" + suffix, seconds, elements);
+
+        seconds = medianSeconds([&] {
+            list.clear();
+            list.insert(values.data(), values.size());
+            list.parallelMergeSort();
+        });
+        reportBenchmark("SingleLinkedList rebuild + parallelMergeSort" + suffix, seconds, elements);
+
+        auto traverse = [&] {
+            uintptr_t sum = 0;
+
+            for (Node* current = list.getHead(); current != nullptr; current = current->next) {
+                sum += current->data;
+            }
+            benchmarkSink = sum;
+        };
+
+        auto visit = [&] {
+            uintptr_t sum = 0;
+
+            list.forEach([&](int value) {
+                sum += value;
+            });
+            benchmarkSink = sum;
+        };
+
+        reportBenchmark("SingleLinkedList traverse (sorted, scattered)" + suffix, medianSeconds(traverse), elements);
+        reportBenchmark("SingleLinkedList forEach (sorted, scattered)" + suffix, medianSeconds(visit), elements);
+        list.compact();
+        reportBenchmark("SingleLinkedList traverse (compacted)" + suffix, medianSeconds(traverse), elements);
+        reportBenchmark("SingleLinkedList forEach (compacted)" + suffix, medianSeconds(visit), elements);
+        list.clear();
+
+        MemoryPool unrolledPool(sizeof(UnrolledNode), elements / UnrolledNode::Capacity + 2);
+        UnrolledLinkedList unrolled(&unrolledPool);
+
+        seconds = medianSeconds([&] {
+            unrolled.clear();
+
+            for (int value : values) {
+                unrolled.insert(value);
+            }
+            unrolled.sort();
+        });
+        reportBenchmark("UnrolledLinkedList rebuild + sort" + suffix, seconds, elements);
+
+        seconds = medianSeconds([&] {
+            uintptr_t sum = 0;
+
+            for (UnrolledNode* current = unrolled.getHead(); current != nullptr; current = current->next) {
+                for (int i = 0; i < current->count; i++) {
+                    sum += current->values[i];
+                }
+            }
+            benchmarkSink = sum;
+        });
+        reportBenchmark("UnrolledLinkedList traverse" + suffix, seconds, elements);
+
+        seconds = medianSeconds([&] {
+            benchmarkSink = static_cast<uintptr_t>(unrolled.sum());
+        });
+        reportBenchmark(std::string("UnrolledLinkedList sum (") + simdKernels().name + ")" + suffix, seconds, elements);
+    }
+}
+
+int runBenchmarks(size_t maxListElements) {
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency()
+              << ", repetitions: " << BenchmarkRepetitions << " (median reported)" << std::endl;
+
+    benchmarkAllocFree();
+    benchmarkContention();
+    benchmarkCrossThreadFree();
+    benchmarkResize();
+    benchmarkList(maxListElements);
+
+    return 0;
+}
+
+// Log-linear latency histogram in the style of HdrHistogram. Values below SubBucketCount are counted exactly and
+// every power of two above that is split into SubBucketCount / 2 equal buckets, so a recorded value is reported
+// within about 3% from fixed storage, and record() is O(1) and never allocates.
+class LatencyHistogram {
+private:
+    static constexpr unsigned SubBucketBits = 5;
+    static constexpr uint64_t SubBucketCount = uint64_t(1) << SubBucketBits;
+    static constexpr uint64_t HalfCount = SubBucketCount / 2;
+    static constexpr size_t BucketCount = (64 - SubBucketBits + 2) * HalfCount; // Enough for the top bit set
+
+    uint64_t counts[BucketCount] = {};
+    uint64_t total = 0;
+    uint64_t maxValue = 0;
+
+public:
+    void record(uint64_t value) {
+        counts[bucketOf(value)]++;
+        total++;
+        maxValue = value > maxValue ? value : maxValue;
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < BucketCount; i++) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        maxValue = other.maxValue > maxValue ? other.maxValue : maxValue;
+    }
+
+    uint64_t count() const {
+        return total;
+    }
+
+    uint64_t max() const {
+        return maxValue;
+    }
+
+    // Highest value in the bucket holding the q-th quantile, capped at the largest value recorded.
+    uint64_t percentile(double q) const {
+        if (total == 0) {
+            return 0;
+        }
+
+        uint64_t rank = static_cast<uint64_t>(q * total + 0.999999);
+        rank = rank < 1 ? 1 : rank;
+        uint64_t seen = 0;
+
+        for (size_t i = 0; i < BucketCount; i++) {
+            seen += counts[i];
+
+            if (seen >= rank) {
+                return highestIn(i) < maxValue ? highestIn(i) : maxValue;
+            }
+        }
+        return maxValue;
+    }
+
+private:
+    static size_t bucketOf(uint64_t value) {
+        if (value < SubBucketCount) {
+            return static_cast<size_t>(value);
+        }
+
+#ifdef _MSC_VER
+        unsigned long top;
+        _BitScanReverse64(&top, value);
+#else
+        unsigned top = 63 - static_cast<unsigned>(__builtin_clzll(value));
+#endif
+        unsigned shift = static_cast<unsigned>(top) - (SubBucketBits - 1);
+        return static_cast<size_t>(shift * HalfCount + (value >> shift));
+    }
+
+    static uint64_t highestIn(size_t bucket) {
+        if (bucket < SubBucketCount) {
+            return bucket;
+        }
+
+        unsigned shift = static_cast<unsigned>(bucket / HalfCount) - 1;
+        uint64_t first = (bucket % HalfCount + HalfCount) << shift;
+        return first + (uint64_t(1) << shift) - 1;
+    }
+};
+
+// Profiling harness, run with `--profile [threads[,threads...]] [allocPercent] [operations]`. Each thread makes
+// `operations` calls against one shared pool, allocating with probability allocPercent while it holds fewer than
+// ProfileLiveBlocks and otherwise freeing a random block it holds, and times every call on its own. The pool
+// starts at ProfileInitialBlocks so the run includes resizes, and each free-list strategy gets the same seeds.
+// Build with -DMEMORY_POOL_PROFILING=1 to split allocation latency by path and histogram lock waits.
+constexpr size_t ProfileLiveBlocks = 4096;
+constexpr size_t ProfileInitialBlocks = 1024;
+
+struct ProfileHistograms {
+    LatencyHistogram allocate;
+    LatencyHistogram fastPath; // Served from the thread's magazine
+    LatencyHistogram sharedPath; // Refilled from the shared free list or bump tail
+    LatencyHistogram resizePath; // Grew the pool
+    LatencyHistogram lockWait; // Time inside lockPool(), for calls of either kind that had to wait
+    LatencyHistogram deallocate;
+
+    void merge(const ProfileHistograms& other) {
+        allocate.merge(other.allocate);
+        fastPath.merge(other.fastPath);
+        sharedPath.merge(other.sharedPath);
+        resizePath.merge(other.resizePath);
+        lockWait.merge(other.lockWait);
+        deallocate.merge(other.deallocate);
+    }
+};
+
+// profileTicks() per nanosecond, measured once against steady_clock.
+double ticksPerNanosecond() {
+    static const double rate = [] {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t startTicks = profileTicks();
+
+        while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(20)) {
+        }
+
+        double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return (profileTicks() - startTicks) / nanoseconds;
+    }();
+    return rate;
+}
+
+void profileWorker(MemoryPool& pool, size_t operations, unsigned allocPercent, uint32_t seed, ProfileHistograms& out) {
+    std::vector<Block*> live;
+    live.reserve(ProfileLiveBlocks);
+    std::mt19937 rng(seed);
+
+    for (size_t i = 0; i < operations; i++) {
+        bool allocate = live.empty() || (live.size() < ProfileLiveBlocks && rng() % 100 < allocPercent);
+        POOL_PROFILE(poolTrace = PoolTrace{});
+
+        if (allocate) {
+            uint64_t start = profileTicks();
+            Block* block = pool.allocateBlock();
+            uint64_t ticks = profileTicks() - start;
+
+            if (block == nullptr) {
+                continue;
+            }
+
+            live.push_back(block);
+            out.allocate.record(ticks);
+#if MEMORY_POOL_PROFILING
+            (poolTrace.resized ? out.resizePath : poolTrace.sharedPath ? out.sharedPath : out.fastPath).record(ticks);
+#endif
+        }
+        else {
+            size_t victim = rng() % live.size();
+            Block* block = live[victim];
+            live[victim] = live.back();
+            live.pop_back();
+
+            uint64_t start = profileTicks();
+            pool.deallocateBlock(block);
+            out.deallocate.record(profileTicks() - start);
+        }
+
+#if MEMORY_POOL_PROFILING
+        if (poolTrace.lockWaitTicks > 0) {
+            out.lockWait.record(poolTrace.lockWaitTicks);
+        }
+#endif
+    }
+
+    for (Block* block : live) {
+        pool.deallocateBlock(block);
+    }
+}
+
+void reportLatency(const std::string& name, const LatencyHistogram& histogram) {
+    double rate = ticksPerNanosecond();
+
+    std::cout << "  " << std::left << std::setw(28) << name << std::right << std::setw(12) << histogram.count()
+              << std::fixed << std::setprecision(0);
+
+    for (uint64_t ticks : {histogram.percentile(0.5), histogram.percentile(0.99), histogram.percentile(0.999), histogram.max()}) {
+        std::cout << std::setw(12) << ticks / rate;
+    }
+    std::cout << std::endl;
+}
+
+int runProfile(const std::vector<size_t>& threadCounts, unsigned allocPercent, size_t operations) {
+#ifdef MEMORY_POOL_SIMD_X86
+    std::cout << "timer: rdtsc, " << std::setprecision(3) << ticksPerNanosecond() << " ticks/ns";
+#else
+    std::cout << "timer: steady_clock";
+#endif
+    std::cout << ", " << allocPercent << "% allocations, " << operations << " calls per thread" << std::endl;
+#if !MEMORY_POOL_PROFILING
+    std::cout << "path and lock-wait breakdown needs a build with -DMEMORY_POOL_PROFILING=1" << std::endl;
+#endif
+
+    for (size_t threads : threadCounts) {
+        for (FreeListStrategy strategy : {FreeListStrategy::Locked, FreeListStrategy::LockFree}) {
+            MemoryPool pool(sizeof(Node), ProfileInitialBlocks, alignof(std::max_align_t), strategy);
+            std::vector<ProfileHistograms> perThread(threads);
+            std::vector<std::thread> workers;
+            std::atomic<size_t> ready{0};
+
+            for (size_t t = 0; t < threads; t++) {
+                workers.emplace_back([&, t] {
+                    ready.fetch_add(1, std::memory_order_relaxed);
+
+                    while (ready.load(std::memory_order_relaxed) < threads) { // Start together so the calls contend
+                        std::this_thread::yield();
+                    }
+                    profileWorker(pool, operations, allocPercent, static_cast<uint32_t>(42 + t), perThread[t]);
+                });
+            }
+
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+
+            ProfileHistograms merged;
+
+            for (const ProfileHistograms& histograms : perThread) {
+                merged.merge(histograms);
+            }
+
+            std::cout << std::endl << (strategy == FreeListStrategy::Locked ? "MemoryPool (locked)" : "MemoryPool (lock-free)")
+                      << " threads=" << threads << ", ns" << std::endl;
+            std::cout << "  " << std::left << std::setw(28) << "" << std::right << std::setw(12) << "calls"
+                      << std::setw(12) << "p50" << std::setw(12) << "p99" << std::setw(12) << "p99.9"
+                      << std::setw(12) << "max" << std::endl;
+            reportLatency("allocateBlock", merged.allocate);
+#if MEMORY_POOL_PROFILING
+            reportLatency("  fast path (magazine)", merged.fastPath);
+            reportLatency("  shared path", merged.sharedPath);
+            reportLatency("  resize path", merged.resizePath);
+#endif
+            reportLatency("deallocateBlock", merged.deallocate);
+#if MEMORY_POOL_PROFILING
+            reportLatency("lock wait", merged.lockWait);
+#endif
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0) {
+        return runBenchmarks(argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000000);
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "--profile") == 0) {
+        std::vector<size_t> threadCounts;
+
+        for (const char* cursor = argc > 2 ? argv[2] : ""; *cursor != '\0';) {
+            char* end;
+            size_t threads = std::strtoull(cursor, &end, 10);
+
+            if (end == cursor || threads == 0 || (*end != ',' && *end != '\0')) {
+                std::cerr << "usage: --profile [threads[,threads...]] [allocPercent] [operations]" << std::endl;
+                return 1;
+            }
+            threadCounts.push_back(threads);
+            cursor = *end == ',' ? end + 1 : end;
+        }
+
+        unsigned allocPercent = argc > 3 ? static_cast<unsigned>(std::strtoul(argv[3], nullptr, 10)) : 50;
+        size_t operations = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 1000000;
+        return runProfile(threadCounts.empty() ? defaultThreadCounts() : threadCounts,
+            allocPercent < 100 ? allocPercent : 100, operations);
+    }
+
+    MemoryPool pool(sizeof(Node), 10); //32 bytes and 10 blocks
+
+    pool.setEventCallback([](const PoolEvent& event, void*) {
+        if (event.type == PoolEventType::Resized) {
+            std::cout << "Memory pool resized. New size: " << event.totalBlocks << " blocks." << std::endl;
+        }
+    });
+
+    SingleLinkedList list(&pool);
+
+    for (int i = 1; i <= 20; ++i) {
+        if (!list.insert(i)) {
+            std::cout << "Memory pool is full. Cannot allocate new node." << std::endl;
+        }
+    }
+
+    std::cout << "Linked list: ";
     list.display();
 
-    list.remove(2);
+    if (list.remove(2)) {
+        std::cout << "Value 2 removed from the list." << std::endl;
+    }
+    else {
+        std::cout << "Value 2 not found in the list." << std::endl;
+    }
     std::cout << "Linked list: ";
     list.display();
 